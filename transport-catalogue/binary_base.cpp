@@ -0,0 +1,329 @@
+#include <cstring>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+#include "binary_base.h"
+#include "domain.h"
+
+namespace domain::binary {
+
+using namespace std::string_literals;
+
+namespace {
+
+constexpr char MAGIC[8] = "TCBASE1";
+constexpr std::size_t ALIGNMENT = 8;
+
+std::size_t AlignUp(std::size_t offset) {
+    return (offset + ALIGNMENT - 1) / ALIGNMENT * ALIGNMENT;
+}
+
+std::uint32_t ToIndex(std::size_t value) {
+    if (value > std::numeric_limits<std::uint32_t>::max()) {
+        throw std::runtime_error("Base is too large for 32-bit indices"s);
+    }
+    return static_cast<std::uint32_t>(value);
+}
+
+[[noreturn]] void ThrowInvalid(const std::string& what) {
+    throw std::runtime_error("Invalid base file: "s + what);
+}
+
+} // namespace
+
+/*
+* Запись
+*/
+
+StringRef BaseWriter::AddString(std::string_view value) {
+    StringRef ref{};
+    ref.offset = strings_.size();
+    ref.size = ToIndex(value.size());
+    strings_.append(value);
+    return ref;
+}
+
+ColorRecord BaseWriter::AddColor(const svg::Color& color) {
+    ColorRecord record{};
+    if (const auto* name = std::get_if<std::string>(&color)) {
+        record.kind = ColorKind::Name;
+        record.name = AddString(*name);
+    } else if (const auto* rgba = std::get_if<svg::Rgba>(&color)) {
+        record.kind = ColorKind::Rgba;
+        record.red = rgba->red;
+        record.green = rgba->green;
+        record.blue = rgba->blue;
+        record.opacity = rgba->opacity;
+    } else if (const auto* rgb = std::get_if<svg::Rgb>(&color)) {
+        record.kind = ColorKind::Rgb;
+        record.red = rgb->red;
+        record.green = rgb->green;
+        record.blue = rgb->blue;
+    } else {
+        record.kind = ColorKind::None;
+    }
+    return record;
+}
+
+void BaseWriter::AddStop(std::string_view name, double latitude, double longitude, const std::vector<DistanceRecord>& distances) {
+    StopRecord record{};
+    record.name = AddString(name);
+    record.latitude = latitude;
+    record.longitude = longitude;
+    record.distances_begin = ToIndex(distances_.size());
+    record.distances_count = ToIndex(distances.size());
+    distances_.insert(distances_.end(), distances.begin(), distances.end());
+    stops_.push_back(record);
+}
+
+void BaseWriter::AddBus(std::string_view name, bool is_roundtrip, const std::vector<std::uint32_t>& stops) {
+    BusRecord record{};
+    record.name = AddString(name);
+    record.stops_begin = ToIndex(bus_stops_.size());
+    record.stops_count = ToIndex(stops.size());
+    record.is_roundtrip = is_roundtrip ? 1 : 0;
+    bus_stops_.insert(bus_stops_.end(), stops.begin(), stops.end());
+    buses_.push_back(record);
+}
+
+void BaseWriter::SetSettings(const Render::RenderSettings& render_settings, const Transport::RouterSettings& router_settings) {
+    settings_.width = render_settings.width;
+    settings_.height = render_settings.height;
+    settings_.padding = render_settings.padding;
+    settings_.line_width = render_settings.line_width;
+    settings_.stop_radius = render_settings.stop_radius;
+    settings_.bus_label_offset[0] = render_settings.bus_label_offset.x;
+    settings_.bus_label_offset[1] = render_settings.bus_label_offset.y;
+    settings_.stop_label_offset[0] = render_settings.stop_label_offset.x;
+    settings_.stop_label_offset[1] = render_settings.stop_label_offset.y;
+    settings_.underlayer_width = render_settings.underlayer_width;
+    settings_.bus_label_font_size = render_settings.bus_label_font_size;
+    settings_.stop_label_font_size = render_settings.stop_label_font_size;
+    settings_.bus_wait_time = router_settings.bus_wait_time;
+    settings_.bus_velocity = router_settings.bus_velocity;
+    settings_.underlayer_color = AddColor(render_settings.underlayer_color);
+    palette_.clear();
+    for (const svg::Color& color : render_settings.color_palette) {
+        palette_.push_back(AddColor(color));
+    }
+}
+
+void BaseWriter::Write(std::ostream& out) const {
+    struct Block {
+        SectionKind kind;
+        std::size_t element_size;
+        const void* data;
+        std::size_t count;
+    };
+    const std::array<Block, SECTION_COUNT> blocks = { {
+        { SectionKind::Strings, 1, strings_.data(), strings_.size() },
+        { SectionKind::Stops, sizeof(StopRecord), stops_.data(), stops_.size() },
+        { SectionKind::Distances, sizeof(DistanceRecord), distances_.data(), distances_.size() },
+        { SectionKind::Buses, sizeof(BusRecord), buses_.data(), buses_.size() },
+        { SectionKind::BusStops, sizeof(std::uint32_t), bus_stops_.data(), bus_stops_.size() },
+        { SectionKind::Palette, sizeof(ColorRecord), palette_.data(), palette_.size() },
+        { SectionKind::Settings, sizeof(SettingsRecord), &settings_, 1 }
+    } };
+
+    Header header{};
+    std::memcpy(header.magic, MAGIC, sizeof(header.magic));
+    header.section_count = static_cast<std::uint32_t>(blocks.size());
+
+    std::array<Section, SECTION_COUNT> sections{};
+    std::size_t offset = sizeof(Header) + sizeof(Section) * blocks.size();
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        offset = AlignUp(offset);
+        sections[i] = { blocks[i].kind, static_cast<std::uint32_t>(blocks[i].element_size), offset, blocks[i].count };
+        offset += blocks[i].element_size * blocks[i].count;
+    }
+
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(sections.data()), sizeof(Section) * sections.size());
+    std::size_t written = sizeof(Header) + sizeof(Section) * sections.size();
+    static constexpr char padding[ALIGNMENT] = {};
+    for (std::size_t i = 0; i < blocks.size(); ++i) {
+        out.write(padding, static_cast<std::streamsize>(sections[i].offset - written));
+        const std::size_t size = blocks[i].element_size * blocks[i].count;
+        out.write(static_cast<const char*>(blocks[i].data), static_cast<std::streamsize>(size));
+        written = sections[i].offset + size;
+    }
+    if (!out) {
+        throw std::runtime_error("Cannot write base"s);
+    }
+}
+
+/*
+* Чтение
+*/
+
+BaseView::BaseView(std::string_view data) : data_(data) {
+    if (data_.size() < sizeof(Header)) {
+        ThrowInvalid("too short"s);
+    }
+    Header header;
+    std::memcpy(&header, data_.data(), sizeof(header));
+    if (std::memcmp(header.magic, MAGIC, sizeof(header.magic)) != 0) {
+        ThrowInvalid("bad magic"s);
+    }
+    if (header.section_count != SECTION_COUNT || data_.size() < sizeof(Header) + sizeof(Section) * SECTION_COUNT) {
+        ThrowInvalid("bad section table"s);
+    }
+    std::memcpy(sections_.data(), data_.data() + sizeof(Header), sizeof(Section) * SECTION_COUNT);
+    Validate();
+}
+
+const Section& BaseView::GetSection(SectionKind kind) const {
+    return sections_[static_cast<std::size_t>(kind) - 1];
+}
+
+template <typename T>
+T BaseView::Read(SectionKind kind, std::size_t index) const {
+    static_assert(std::is_trivially_copyable_v<T>, "Records are plain bytes");
+    const Section& section = GetSection(kind);
+    T value;
+    std::memcpy(&value, data_.data() + section.offset + index * sizeof(T), sizeof(T));
+    return value;
+}
+
+void BaseView::Validate() const {
+    const std::size_t element_sizes[SECTION_COUNT] = {
+        1, sizeof(StopRecord), sizeof(DistanceRecord), sizeof(BusRecord),
+        sizeof(std::uint32_t), sizeof(ColorRecord), sizeof(SettingsRecord)
+    };
+    for (std::size_t i = 0; i < SECTION_COUNT; ++i) {
+        const Section& section = sections_[i];
+        if (static_cast<std::size_t>(section.kind) != i + 1 || section.element_size != element_sizes[i]) {
+            ThrowInvalid("unexpected section "s + std::to_string(i + 1));
+        }
+        if (section.offset > data_.size() || section.count > (data_.size() - section.offset) / section.element_size) {
+            ThrowInvalid("section "s + std::to_string(i + 1) + " is out of bounds"s);
+        }
+    }
+    if (GetSection(SectionKind::Settings).count != 1) {
+        ThrowInvalid("settings are missing"s);
+    }
+
+    const std::size_t string_bytes = GetSection(SectionKind::Strings).count;
+    auto check_string = [string_bytes](const StringRef& ref) {
+        if (ref.offset > string_bytes || ref.size > string_bytes - ref.offset) {
+            ThrowInvalid("string is out of bounds"s);
+        }
+    };
+    auto check_range = [](std::uint64_t begin, std::uint64_t count, std::uint64_t size) {
+        if (begin > size || count > size - begin) {
+            ThrowInvalid("range is out of bounds"s);
+        }
+    };
+    auto check_color = [&check_string](const ColorRecord& color) {
+        if (color.kind > ColorKind::Rgba) {
+            ThrowInvalid("unknown color kind"s);
+        }
+        if (color.kind == ColorKind::Name) {
+            check_string(color.name);
+        }
+    };
+
+    const std::size_t stop_count = GetStopCount();
+    const std::size_t distance_count = GetSection(SectionKind::Distances).count;
+    for (std::size_t i = 0; i < stop_count; ++i) {
+        const StopRecord stop = GetStop(i);
+        check_string(stop.name);
+        check_range(stop.distances_begin, stop.distances_count, distance_count);
+    }
+    for (std::size_t i = 0; i < distance_count; ++i) {
+        if (GetDistance(i).to >= stop_count) {
+            ThrowInvalid("distance to unknown stop"s);
+        }
+    }
+    const std::size_t bus_stop_count = GetSection(SectionKind::BusStops).count;
+    for (std::size_t i = 0; i < GetBusCount(); ++i) {
+        const BusRecord bus = GetBus(i);
+        check_string(bus.name);
+        check_range(bus.stops_begin, bus.stops_count, bus_stop_count);
+    }
+    for (std::size_t i = 0; i < bus_stop_count; ++i) {
+        if (GetBusStop(i) >= stop_count) {
+            ThrowInvalid("bus route through unknown stop"s);
+        }
+    }
+    for (std::size_t i = 0; i < GetSection(SectionKind::Palette).count; ++i) {
+        check_color(Read<ColorRecord>(SectionKind::Palette, i));
+    }
+    check_color(Read<SettingsRecord>(SectionKind::Settings, 0).underlayer_color);
+}
+
+std::size_t BaseView::GetStopCount() const {
+    return GetSection(SectionKind::Stops).count;
+}
+
+StopRecord BaseView::GetStop(std::size_t index) const {
+    return Read<StopRecord>(SectionKind::Stops, index);
+}
+
+DistanceRecord BaseView::GetDistance(std::size_t index) const {
+    return Read<DistanceRecord>(SectionKind::Distances, index);
+}
+
+std::size_t BaseView::GetBusCount() const {
+    return GetSection(SectionKind::Buses).count;
+}
+
+BusRecord BaseView::GetBus(std::size_t index) const {
+    return Read<BusRecord>(SectionKind::Buses, index);
+}
+
+std::uint32_t BaseView::GetBusStop(std::size_t index) const {
+    return Read<std::uint32_t>(SectionKind::BusStops, index);
+}
+
+std::string_view BaseView::GetString(const StringRef& ref) const {
+    return data_.substr(GetSection(SectionKind::Strings).offset + ref.offset, ref.size);
+}
+
+svg::Color BaseView::ToColor(const ColorRecord& record) const {
+    switch (record.kind) {
+        case ColorKind::Name:
+            return std::string(GetString(record.name));
+        case ColorKind::Rgb:
+            return svg::Rgb(record.red, record.green, record.blue);
+        case ColorKind::Rgba:
+            return svg::Rgba(record.red, record.green, record.blue, record.opacity);
+        case ColorKind::None:
+            break;
+    }
+    return svg::NoneColor;
+}
+
+Render::RenderSettings BaseView::GetRenderSettings() const {
+    const SettingsRecord settings = Read<SettingsRecord>(SectionKind::Settings, 0);
+    Render::RenderSettings render_settings;
+    render_settings.width = settings.width;
+    render_settings.height = settings.height;
+    render_settings.padding = settings.padding;
+    render_settings.line_width = settings.line_width;
+    render_settings.stop_radius = settings.stop_radius;
+    render_settings.bus_label_font_size = settings.bus_label_font_size;
+    render_settings.bus_label_offset = { settings.bus_label_offset[0], settings.bus_label_offset[1] };
+    render_settings.stop_label_font_size = settings.stop_label_font_size;
+    render_settings.stop_label_offset = { settings.stop_label_offset[0], settings.stop_label_offset[1] };
+    render_settings.underlayer_color = ToColor(settings.underlayer_color);
+    render_settings.underlayer_width = settings.underlayer_width;
+    const std::size_t palette_size = GetSection(SectionKind::Palette).count;
+    render_settings.color_palette.reserve(palette_size);
+    for (std::size_t i = 0; i < palette_size; ++i) {
+        render_settings.color_palette.push_back(ToColor(Read<ColorRecord>(SectionKind::Palette, i)));
+    }
+    return render_settings;
+}
+
+Transport::RouterSettings BaseView::GetRouterSettings() const {
+    const SettingsRecord settings = Read<SettingsRecord>(SectionKind::Settings, 0);
+    return { settings.bus_wait_time, settings.bus_velocity };
+}
+
+std::size_t BaseView::GetSize() const {
+    return data_.size();
+}
+
+} // end domain::binary
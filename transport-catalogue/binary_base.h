@@ -0,0 +1,193 @@
+#pragma once
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "svg.h"
+
+namespace Render {
+    struct RenderSettings;
+}
+
+namespace Transport {
+    struct RouterSettings;
+}
+
+/*
+* Двоичный формат базы: остановки, расстояния, автобусы и настройки карты и
+* маршрутов без разбора текста.
+*
+* Файл — заголовок Header, таблица из section_count записей Section и сами секции.
+* Секция — массив записей одного размера с выровненного на 8 байт смещения.
+* Числа в порядке байтов машины, как в выгрузке колонок. Остановки и автобусы
+* идут в порядке входных запросов, ссылки между ними — индексы в секциях:
+*
+*   Strings (байты): имена и названия цветов, на них указывают StringRef
+*   Stops (StopRecord): расстояния остановки — [distances_begin, +distances_count) в Distances
+*   Distances (DistanceRecord): to — индекс в Stops
+*   Buses (BusRecord): остановки маршрута — [stops_begin, +stops_count) в BusStops
+*   BusStops (u32): индексы в Stops
+*   Palette (ColorRecord): палитра карты
+*   Settings (SettingsRecord): одна запись с остальными настройками карты и маршрутов
+*/
+namespace domain::binary {
+
+enum class SectionKind : std::uint32_t {
+    Strings = 1,
+    Stops = 2,
+    Distances = 3,
+    Buses = 4,
+    BusStops = 5,
+    Palette = 6,
+    Settings = 7
+};
+
+constexpr std::size_t SECTION_COUNT = 7;
+
+struct Header {
+    char magic[8];                  // "TCBASE1\0"
+    std::uint32_t section_count;
+    std::uint32_t reserved;
+};
+
+struct Section {
+    SectionKind kind;
+    std::uint32_t element_size;
+    std::uint64_t offset;
+    std::uint64_t count;
+};
+
+struct StringRef {
+    std::uint64_t offset;
+    std::uint32_t size;
+    std::uint32_t reserved;
+};
+
+struct StopRecord {
+    StringRef name;
+    double latitude;
+    double longitude;
+    std::uint32_t distances_begin;
+    std::uint32_t distances_count;
+};
+
+struct DistanceRecord {
+    std::uint32_t to;
+    std::uint32_t reserved;
+    std::uint64_t distance;
+};
+
+struct BusRecord {
+    StringRef name;
+    std::uint32_t stops_begin;
+    std::uint32_t stops_count;
+    std::uint8_t is_roundtrip;
+    std::uint8_t reserved[7];
+};
+
+enum class ColorKind : std::uint8_t {
+    None = 0,
+    Name = 1,
+    Rgb = 2,
+    Rgba = 3
+};
+
+struct ColorRecord {
+    ColorKind kind;
+    std::uint8_t red;
+    std::uint8_t green;
+    std::uint8_t blue;
+    std::uint32_t reserved;
+    StringRef name;                 // ColorKind::Name
+    double opacity;                 // ColorKind::Rgba
+};
+
+struct SettingsRecord {
+    double width;
+    double height;
+    double padding;
+    double line_width;
+    double stop_radius;
+    double bus_label_offset[2];
+    double stop_label_offset[2];
+    double underlayer_width;
+    std::int32_t bus_label_font_size;
+    std::int32_t stop_label_font_size;
+    std::int32_t bus_wait_time;
+    std::int32_t bus_velocity;
+    ColorRecord underlayer_color;
+};
+
+static_assert(sizeof(Header) == 16, "Base header must stay 16 bytes");
+static_assert(sizeof(Section) == 24, "Section entry must stay 24 bytes");
+static_assert(sizeof(StopRecord) == 40, "Stop record must stay 40 bytes");
+static_assert(sizeof(DistanceRecord) == 16, "Distance record must stay 16 bytes");
+static_assert(sizeof(BusRecord) == 32, "Bus record must stay 32 bytes");
+static_assert(sizeof(ColorRecord) == 32, "Color record must stay 32 bytes");
+static_assert(sizeof(SettingsRecord) == 128, "Settings record must stay 128 bytes");
+
+/* Собирает базу в памяти и пишет её одним файлом */
+class BaseWriter {
+public:
+    /* Расстояния ссылаются на индексы остановок в порядке добавления, в том числе будущих */
+    void AddStop(std::string_view name, double latitude, double longitude, const std::vector<DistanceRecord>& distances);
+    void AddBus(std::string_view name, bool is_roundtrip, const std::vector<std::uint32_t>& stops);
+    void SetSettings(const Render::RenderSettings& render_settings, const Transport::RouterSettings& router_settings);
+
+    /* При ошибке записи бросает std::runtime_error */
+    void Write(std::ostream& out) const;
+
+private:
+    StringRef AddString(std::string_view value);
+    ColorRecord AddColor(const svg::Color& color);
+
+    std::string strings_;
+    std::vector<StopRecord> stops_;
+    std::vector<DistanceRecord> distances_;
+    std::vector<BusRecord> buses_;
+    std::vector<std::uint32_t> bus_stops_;
+    std::vector<ColorRecord> palette_;
+    SettingsRecord settings_{};
+};
+
+/*
+* Чтение базы из буфера, например отображённого в память файла; буфер должен
+* жить дольше представления. Заголовок, границы секций и все индексы проверяются
+* в конструкторе: при ошибке бросается std::runtime_error.
+*/
+class BaseView {
+public:
+    explicit BaseView(std::string_view data);
+
+    std::size_t GetStopCount() const;
+    StopRecord GetStop(std::size_t index) const;
+    DistanceRecord GetDistance(std::size_t index) const;
+
+    std::size_t GetBusCount() const;
+    BusRecord GetBus(std::size_t index) const;
+    std::uint32_t GetBusStop(std::size_t index) const;
+
+    std::string_view GetString(const StringRef& ref) const;
+
+    Render::RenderSettings GetRenderSettings() const;
+    Transport::RouterSettings GetRouterSettings() const;
+
+    std::size_t GetSize() const;
+
+private:
+    template <typename T>
+    T Read(SectionKind kind, std::size_t index) const;
+    const Section& GetSection(SectionKind kind) const;
+    void Validate() const;
+    svg::Color ToColor(const ColorRecord& record) const;
+
+    std::string_view data_;
+    std::array<Section, SECTION_COUNT> sections_{};
+};
+
+} // end domain::binary
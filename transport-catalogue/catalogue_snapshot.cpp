@@ -0,0 +1,287 @@
+#include <algorithm>
+#include <stdexcept>
+#include <tuple>
+#include <unordered_map>
+
+#include "catalogue_snapshot.h"
+
+namespace Transport {
+
+namespace {
+
+/* Строит совершенный хеш над именами записей и таблицу слот -> индекс записи */
+template <typename Record, typename Id>
+PerfectHash BuildNameIndex(const std::vector<Record>& records, std::vector<Id>& slots) {
+    std::vector<std::string_view> names;
+    names.reserve(records.size());
+    for (const Record& record : records) {
+        names.push_back(record.name);
+    }
+    PerfectHash hash(names);
+    slots.assign(records.size(), 0);
+    for (std::size_t id = 0; id < records.size(); ++id) {
+        slots[hash(names[id])] = static_cast<Id>(id);
+    }
+    return hash;
+}
+
+/* Слот совершенного хеша определён и для чужих имён, поэтому имя сверяется */
+template <typename Record, typename Id>
+std::optional<Id> FindByName(const std::vector<Record>& records, const PerfectHash& hash,
+    const std::vector<Id>& slots, std::string_view name) {
+    if (records.empty()) {
+        return std::nullopt;
+    }
+    const Id id = slots[hash(name)];
+    if (records[id].name != name) {
+        return std::nullopt;
+    }
+    return id;
+}
+
+/* Дописывает маршрут как разности соседних идентификаторов в zigzag-varint; первый — разность с нулём */
+void EncodeRoute(const std::vector<StopId>& route, std::vector<std::uint8_t>& code) {
+    StopId previous = 0;
+    for (StopId stop : route) {
+        const std::int64_t delta = static_cast<std::int64_t>(stop) - static_cast<std::int64_t>(previous);
+        std::uint64_t zigzag = (static_cast<std::uint64_t>(delta) << 1) ^ static_cast<std::uint64_t>(delta >> 63);
+        while (zigzag >= 0x80) {
+            code.push_back(static_cast<std::uint8_t>(zigzag | 0x80));
+            zigzag >>= 7;
+        }
+        code.push_back(static_cast<std::uint8_t>(zigzag));
+        previous = stop;
+    }
+}
+
+} // namespace
+
+/*
+* Transport::CatalogueSnapshot
+*/
+
+CatalogueSnapshot::CatalogueSnapshot(const Catalogue& catalogue, const SnapshotOptions& options) :
+    compact_routes_(options.compact_routes) {
+    const StopsDictionary& all_stops = catalogue.GetAllStops();
+    const BusesDictionary& all_buses = catalogue.GetAllBuses();
+
+    /* Словари уже упорядочены по имени, поэтому индекс сразу становится идентификатором */
+    std::unordered_map<const Stop*, StopId> stop_ids;
+    stops_.reserve(all_stops.size());
+    for (const auto& [name, stop] : all_stops) {
+        stop_ids[stop.get()] = static_cast<StopId>(stops_.size());
+        stops_.push_back({ stop->GetName(), stop->GetCoordinates() });
+    }
+
+    buses_.reserve(all_buses.size());
+    bus_stops_offsets_.reserve(all_buses.size() + 1);
+    bus_stops_offsets_.push_back(0);
+    std::vector<StopId> route;
+    for (const auto& [name, bus] : all_buses) {
+        BusStats stats;
+        stats.curvature = bus->GetCurvature();
+        stats.route_length = bus->GetRouteLength();
+        stats.stop_count = bus->GetRouteSize();
+        stats.unique_stop_count = bus->GetUniqueStopsSize();
+
+        route.clear();
+        for (auto it = bus->route_begin(); it != bus->route_end(); ++it) {
+            route.push_back(stop_ids.at(it->stop.get()));
+        }
+        BusRecord record{ bus->GetName(), bus->GetType(), stats };
+        if (!route.empty()) {
+            record.first_stop = route.front();
+            record.last_stop = route.back();
+        }
+        buses_.push_back(std::move(record));
+
+        if (compact_routes_) {
+            EncodeRoute(route, bus_stops_code_);
+            bus_stops_offsets_.push_back(static_cast<std::uint32_t>(bus_stops_code_.size()));
+        } else {
+            bus_stops_.insert(bus_stops_.end(), route.begin(), route.end());
+            bus_stops_offsets_.push_back(static_cast<std::uint32_t>(bus_stops_.size()));
+        }
+    }
+    bus_stops_code_.shrink_to_fit();
+
+    stop_hash_ = BuildNameIndex(stops_, stop_slots_);
+    bus_hash_ = BuildNameIndex(buses_, bus_slots_);
+
+    std::vector<std::string_view> stop_names;
+    stop_names.reserve(stops_.size());
+    for (const StopRecord& stop : stops_) {
+        stop_names.push_back(stop.name);
+    }
+    stop_name_index_ = StopNameIndex(stop_names);
+
+    /* Имена автобусов берутся из buses_, который дальше не перевыделяется */
+    stop_buses_offsets_.reserve(stops_.size() + 1);
+    stop_buses_offsets_.push_back(0);
+    for (const auto& [name, stop] : all_stops) {
+        for (std::string_view bus_name : stop->GetBusNames()) {
+            const BusId bus_id = *FindBus(bus_name);
+            stop_buses_.push_back(bus_id);
+            stop_bus_names_.push_back(buses_[bus_id].name);
+        }
+        stop_buses_offsets_.push_back(static_cast<std::uint32_t>(stop_buses_.size()));
+    }
+
+    bus_words_ = (buses_.size() + 63) / 64;
+    stop_bus_bits_.assign(stops_.size() * bus_words_, 0);
+    for (StopId stop = 0; stop < stops_.size(); ++stop) {
+        for (BusId bus : GetStopBuses(stop)) {
+            stop_bus_bits_[stop * bus_words_ + bus / 64] |= std::uint64_t{1} << (bus % 64);
+        }
+    }
+
+    const SegmentsMap& segments = catalogue.GetSegmentsMap();
+    segments_.reserve(segments.size());
+    for (const auto& [segment, distance] : segments) {
+        segments_.push_back({
+            stop_ids.at(segment.a.lock().get()),
+            stop_ids.at(segment.b.lock().get()),
+            distance
+        });
+    }
+    std::sort(segments_.begin(), segments_.end(), [](const Segment& lhs, const Segment& rhs) {
+        return std::tie(lhs.from, lhs.to) < std::tie(rhs.from, rhs.to);
+    });
+}
+
+std::optional<StopId> CatalogueSnapshot::FindStop(std::string_view name) const {
+    return FindByName(stops_, stop_hash_, stop_slots_, name);
+}
+
+std::optional<BusId> CatalogueSnapshot::FindBus(std::string_view name) const {
+    return FindByName(buses_, bus_hash_, bus_slots_, name);
+}
+
+const StopNameIndex& CatalogueSnapshot::GetStopNameIndex() const {
+    return stop_name_index_;
+}
+
+std::size_t CatalogueSnapshot::GetStopCount() const {
+    return stops_.size();
+}
+
+std::size_t CatalogueSnapshot::GetBusCount() const {
+    return buses_.size();
+}
+
+const CatalogueSnapshot::StopRecord& CatalogueSnapshot::GetStop(StopId id) const {
+    return stops_.at(id);
+}
+
+const CatalogueSnapshot::BusRecord& CatalogueSnapshot::GetBus(BusId id) const {
+    return buses_.at(id);
+}
+
+CatalogueSnapshot::BusIdRange CatalogueSnapshot::GetStopBuses(StopId id) const {
+    return {
+        stop_buses_.begin() + stop_buses_offsets_.at(id),
+        stop_buses_.begin() + stop_buses_offsets_.at(id + 1)
+    };
+}
+
+domain::BusNamesRange CatalogueSnapshot::GetStopBusNames(StopId id) const {
+    return {
+        stop_bus_names_.begin() + stop_buses_offsets_.at(id),
+        stop_bus_names_.begin() + stop_buses_offsets_.at(id + 1)
+    };
+}
+
+bool CatalogueSnapshot::HasDirectBus(StopId from, StopId to) const {
+    const std::uint64_t* from_bits = stop_bus_bits_.data() + std::size_t{from} * bus_words_;
+    const std::uint64_t* to_bits = stop_bus_bits_.data() + std::size_t{to} * bus_words_;
+    /* Простой цикл по словам компилятор сам переводит в векторные AND */
+    std::uint64_t common = 0;
+    for (std::size_t word = 0; word < bus_words_; ++word) {
+        common |= from_bits[word] & to_bits[word];
+    }
+    return common != 0;
+}
+
+std::vector<BusId> CatalogueSnapshot::GetDirectBuses(StopId from, StopId to) const {
+    const std::uint64_t* from_bits = stop_bus_bits_.data() + std::size_t{from} * bus_words_;
+    const std::uint64_t* to_bits = stop_bus_bits_.data() + std::size_t{to} * bus_words_;
+    std::vector<BusId> result;
+    for (std::size_t word = 0; word < bus_words_; ++word) {
+        for (std::uint64_t common = from_bits[word] & to_bits[word]; common != 0; common &= common - 1) {
+            result.push_back(static_cast<BusId>(word * 64 + __builtin_ctzll(common)));
+        }
+    }
+    return result;
+}
+
+CatalogueSnapshot::StopIdRange CatalogueSnapshot::GetBusStops(BusId id) const {
+    if (compact_routes_) {
+        const std::uint8_t* end = bus_stops_code_.data() + bus_stops_offsets_.at(id + 1);
+        return {
+            RouteStopIterator::Encoded(bus_stops_code_.data() + bus_stops_offsets_.at(id), end),
+            RouteStopIterator::Encoded(end, end)
+        };
+    }
+    return {
+        RouteStopIterator::Plain(bus_stops_.data() + bus_stops_offsets_.at(id)),
+        RouteStopIterator::Plain(bus_stops_.data() + bus_stops_offsets_.at(id + 1))
+    };
+}
+
+std::size_t CatalogueSnapshot::GetDistance(StopId from, StopId to) const {
+    auto find_segment = [this](StopId a, StopId b) {
+        return std::lower_bound(segments_.begin(), segments_.end(), std::pair{ a, b }, [](const Segment& segment, std::pair<StopId, StopId> key) {
+            return std::tie(segment.from, segment.to) < std::tie(key.first, key.second);
+        });
+    };
+    if (auto it = find_segment(from, to); it != segments_.end() && it->from == from && it->to == to) {
+        return it->distance;
+    }
+    if (auto it = find_segment(to, from); it != segments_.end() && it->from == to && it->to == from) {
+        return it->distance;
+    }
+    // Расстояние до самой себя по-умолчанию
+    return 0;
+}
+
+const std::vector<CatalogueSnapshot::Segment>& CatalogueSnapshot::GetSegments() const {
+    return segments_;
+}
+
+memory::Usage CatalogueSnapshot::GetMemoryUsage() const {
+    std::size_t names_bytes = 0;
+    for (const StopRecord& stop : stops_) {
+        names_bytes += memory::GetHeapBytes(stop.name);
+    }
+    for (const BusRecord& bus : buses_) {
+        names_bytes += memory::GetHeapBytes(bus.name);
+    }
+    return memory::Usage{ "snapshot", sizeof(CatalogueSnapshot), {} }
+        .AddPart("stops", memory::GetHeapBytes(stops_))
+        .AddPart("buses", memory::GetHeapBytes(buses_))
+        .AddPart("names", names_bytes)
+        .AddPart("name_index", stop_hash_.GetMemoryUsage() + memory::GetHeapBytes(stop_slots_)
+            + bus_hash_.GetMemoryUsage() + memory::GetHeapBytes(bus_slots_))
+        .AddPart("stop_name_index", stop_name_index_.GetMemoryUsage())
+        .AddPart("stop_buses", memory::GetHeapBytes(stop_buses_offsets_) + memory::GetHeapBytes(stop_buses_) + memory::GetHeapBytes(stop_bus_names_))
+        .AddPart("stop_bus_bits", memory::GetHeapBytes(stop_bus_bits_))
+        .AddPart("bus_stops", memory::GetHeapBytes(bus_stops_offsets_) + memory::GetHeapBytes(bus_stops_) + memory::GetHeapBytes(bus_stops_code_))
+        .AddPart("segments", memory::GetHeapBytes(segments_));
+}
+
+memory::Usage CatalogueSnapshot::GetRouteEncodingSavings() const {
+    memory::Usage usage{ "route_encoding_savings", 0, {} };
+    if (!compact_routes_) {
+        return usage;
+    }
+    for (BusId id = 0; id < buses_.size(); ++id) {
+        const StopIdRange route = GetBusStops(id);
+        const std::size_t plain_bytes = std::distance(route.begin(), route.end()) * sizeof(StopId);
+        const std::size_t encoded_bytes = bus_stops_offsets_[id + 1] - bus_stops_offsets_[id];
+        // Очень далёкие соседние идентификаторы кодируются длиннее 4 байт: экономии нет
+        usage.AddPart(buses_[id].name, plain_bytes > encoded_bytes ? plain_bytes - encoded_bytes : 0);
+    }
+    return usage;
+}
+
+} // end Transport
@@ -0,0 +1,220 @@
+#pragma once
+
+#include <cstdint>
+#include <iterator>
+#include <memory>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+#include "domain.h"
+#include "geo.h"
+#include "memory_usage.h"
+#include "perfect_hash.h"
+#include "ranges.h"
+#include "stop_name_index.h"
+#include "transport_catalogue.h"
+
+namespace Transport {
+
+using StopId = std::uint32_t;
+using BusId = std::uint32_t;
+
+/* Статистика маршрута, посчитанная при финализации каталога */
+struct BusStats {
+    double curvature = 0.0;
+    std::size_t route_length = 0;
+    std::size_t stop_count = 0;
+    std::size_t unique_stop_count = 0;
+};
+
+/*
+* Итератор остановок маршрута. Читает либо обычный массив идентификаторов,
+* либо сжатую запись — разности соседних идентификаторов в zigzag-varint, —
+* декодируя её на ходу. Значение декодируется внутрь итератора, поэтому
+* разыменование возвращает копию, а итератор — только однопроходный.
+*/
+class RouteStopIterator {
+public:
+    using iterator_category = std::input_iterator_tag;
+    using value_type = StopId;
+    using difference_type = std::ptrdiff_t;
+    using pointer = void;
+    using reference = StopId;
+
+    RouteStopIterator() = default;
+
+    static RouteStopIterator Plain(const StopId* pos) {
+        RouteStopIterator it;
+        it.plain_ = pos;
+        return it;
+    }
+
+    static RouteStopIterator Encoded(const std::uint8_t* pos, const std::uint8_t* end) {
+        RouteStopIterator it;
+        it.pos_ = pos;
+        it.end_ = end;
+        it.Decode();
+        return it;
+    }
+
+    reference operator*() const {
+        return plain_ ? *plain_ : current_;
+    }
+
+    RouteStopIterator& operator++() {
+        if (plain_) {
+            ++plain_;
+        } else {
+            pos_ = next_;
+            Decode();
+        }
+        return *this;
+    }
+
+    RouteStopIterator operator++(int) {
+        auto o(*this);
+        ++(*this);
+        return o;
+    }
+
+    bool operator==(const RouteStopIterator& rhs) const {
+        return plain_ == rhs.plain_ && pos_ == rhs.pos_;
+    }
+
+    bool operator!=(const RouteStopIterator& rhs) const {
+        return !(*this == rhs);
+    }
+
+private:
+    void Decode() {
+        if (pos_ == end_) {
+            return;
+        }
+        std::uint64_t zigzag = 0;
+        int shift = 0;
+        next_ = pos_;
+        while (*next_ & 0x80) {
+            zigzag |= std::uint64_t{ *next_++ & 0x7fu } << shift;
+            shift += 7;
+        }
+        zigzag |= std::uint64_t{ *next_++ } << shift;
+        const std::int64_t delta = static_cast<std::int64_t>(zigzag >> 1) ^ -static_cast<std::int64_t>(zigzag & 1);
+        current_ = static_cast<StopId>(static_cast<std::int64_t>(current_) + delta);
+    }
+
+    const StopId* plain_ = nullptr;
+    const std::uint8_t* pos_ = nullptr;   // начало текущего значения
+    const std::uint8_t* next_ = nullptr;  // начало следующего
+    const std::uint8_t* end_ = nullptr;
+    StopId current_ = 0;                  // предыдущее значение, от которого отсчитывается разность
+};
+
+/*
+* Неизменяемый снимок каталога, оптимизированный для чтения.
+* Остановки и автобусы хранятся в отсортированных по имени непрерывных массивах,
+* идентификатор сущности — её индекс в массиве. После построения снимок
+* не меняется и может одновременно читаться из нескольких потоков.
+*/
+class CatalogueSnapshot {
+public:
+    using StopIdRange = ranges::Range<RouteStopIterator>;
+    using BusIdRange = ranges::Range<std::vector<BusId>::const_iterator>;
+
+    /* Дорожный сегмент в том виде, в каком он задан во входных данных */
+    struct Segment {
+        StopId from;
+        StopId to;
+        std::size_t distance;
+    };
+
+    struct StopRecord {
+        std::string name;
+        Geo::Coordinates coordinates;
+    };
+
+    struct BusRecord {
+        std::string name;
+        RouteType type;
+        BusStats stats;
+        // Конечные остановки прямого направления; для пустого маршрута не определены
+        StopId first_stop = 0;
+        StopId last_stop = 0;
+    };
+
+    explicit CatalogueSnapshot(const Catalogue& catalogue, const SnapshotOptions& options = {});
+
+    // Снимок хранит string_view на собственные строки, поэтому не копируется
+    CatalogueSnapshot(const CatalogueSnapshot&) = delete;
+    CatalogueSnapshot& operator=(const CatalogueSnapshot&) = delete;
+
+    std::optional<StopId> FindStop(std::string_view name) const;
+    std::optional<BusId> FindBus(std::string_view name) const;
+
+    /* Поиск остановок по префиксу имени, в том числе с опечатками */
+    const StopNameIndex& GetStopNameIndex() const;
+
+    std::size_t GetStopCount() const;
+    std::size_t GetBusCount() const;
+
+    const StopRecord& GetStop(StopId id) const;
+    const BusRecord& GetBus(BusId id) const;
+
+    /* Автобусы остановки по возрастанию идентификатора (он же порядок имён) */
+    BusIdRange GetStopBuses(StopId id) const;
+    domain::BusNamesRange GetStopBusNames(StopId id) const;
+
+    /* Есть ли автобус, проходящий через обе остановки: пересечение битовых множеств */
+    bool HasDirectBus(StopId from, StopId to) const;
+    /* Автобусы, проходящие через обе остановки, по возрастанию идентификатора */
+    std::vector<BusId> GetDirectBuses(StopId from, StopId to) const;
+
+    /* Остановки маршрута в порядке добавления; для линейного маршрута — только прямое направление */
+    StopIdRange GetBusStops(BusId id) const;
+
+    /* Дорожное расстояние с теми же правилами, что и Catalogue::GetDistance */
+    std::size_t GetDistance(StopId from, StopId to) const;
+    /* Все сегменты, отсортированные по паре (from, to) */
+    const std::vector<Segment>& GetSegments() const;
+
+    memory::Usage GetMemoryUsage() const;
+    /* Сколько байт сэкономило сжатие последовательностей остановок, по автобусам */
+    memory::Usage GetRouteEncodingSavings() const;
+
+private:
+
+    std::vector<StopRecord> stops_;
+    std::vector<BusRecord> buses_;
+
+    /* Поиск по имени за одно обращение: слот совершенного хеша -> идентификатор */
+    PerfectHash stop_hash_;
+    std::vector<StopId> stop_slots_;
+    PerfectHash bus_hash_;
+    std::vector<BusId> bus_slots_;
+
+    StopNameIndex stop_name_index_;
+
+    /* Списки автобусов остановок: stop_buses_[stop_buses_offsets_[id] .. stop_buses_offsets_[id + 1]) */
+    std::vector<std::uint32_t> stop_buses_offsets_;
+    std::vector<BusId> stop_buses_;
+    std::vector<std::string_view> stop_bus_names_;
+
+    /* Те же списки как битовые множества по BusId: stop_bus_bits_[id * bus_words_ .. (id + 1) * bus_words_) */
+    std::size_t bus_words_ = 0;
+    std::vector<std::uint64_t> stop_bus_bits_;
+
+    /*
+    * Последовательности остановок маршрутов в том же формате: либо массив идентификаторов,
+    * либо при compact_routes — байтовая сжатая запись, тогда смещения указаны в байтах
+    */
+    bool compact_routes_ = false;
+    std::vector<std::uint32_t> bus_stops_offsets_;
+    std::vector<StopId> bus_stops_;
+    std::vector<std::uint8_t> bus_stops_code_;
+
+    /* Сегменты дорожной сети, отсортированные по паре (from, to) */
+    std::vector<Segment> segments_;
+};
+
+} // end Transport
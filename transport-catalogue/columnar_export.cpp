@@ -0,0 +1,182 @@
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+#include "columnar_export.h"
+#include "parallel.h"
+
+namespace Transport {
+
+namespace {
+
+using namespace std::string_literals;
+
+template <typename T>
+struct ColumnTraits;
+
+template <> struct ColumnTraits<std::uint8_t> { static constexpr ColumnType type = ColumnType::U8; };
+template <> struct ColumnTraits<std::uint32_t> { static constexpr ColumnType type = ColumnType::U32; };
+template <> struct ColumnTraits<std::uint64_t> { static constexpr ColumnType type = ColumnType::U64; };
+template <> struct ColumnTraits<double> { static constexpr ColumnType type = ColumnType::F64; };
+template <> struct ColumnTraits<char> { static constexpr ColumnType type = ColumnType::Bytes; };
+
+template <typename T>
+void WriteColumn(const std::filesystem::path& path, const std::vector<T>& values) {
+    ColumnHeader header{};
+    std::memcpy(header.magic, "TCCOL01", 8);
+    header.type = ColumnTraits<T>::type;
+    header.element_size = sizeof(T);
+    header.count = values.size();
+
+    std::ofstream out(path, std::ios::binary | std::ios::trunc);
+    out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    out.write(reinterpret_cast<const char*>(values.data()), static_cast<std::streamsize>(values.size() * sizeof(T)));
+    if (!out) {
+        throw std::runtime_error("Cannot write column "s + path.string());
+    }
+}
+
+/* Имена записей как пара колонок: смещения и склеенные байты */
+template <typename GetName>
+void WriteNames(const std::filesystem::path& directory, const std::string& column, std::size_t count, GetName get_name) {
+    std::vector<std::uint64_t> offsets;
+    std::vector<char> bytes;
+    offsets.reserve(count + 1);
+    offsets.push_back(0);
+    for (std::size_t id = 0; id < count; ++id) {
+        const std::string& name = get_name(id);
+        bytes.insert(bytes.end(), name.begin(), name.end());
+        offsets.push_back(bytes.size());
+    }
+    WriteColumn(directory / (column + ".offsets"), offsets);
+    WriteColumn(directory / column, bytes);
+}
+
+/* Одно поле каждого автобуса или каждой остановки */
+template <typename T, typename GetValue>
+std::vector<T> Collect(std::size_t count, GetValue get_value) {
+    std::vector<T> values;
+    values.reserve(count);
+    for (std::size_t id = 0; id < count; ++id) {
+        values.push_back(static_cast<T>(get_value(id)));
+    }
+    return values;
+}
+
+} // namespace
+
+void ExportColumns(
+    const CatalogueSnapshot& snapshot,
+    const Router* router,
+    const std::string& directory,
+    std::size_t thread_count
+) {
+    const std::filesystem::path dir(directory);
+    std::filesystem::create_directories(dir);
+
+    const std::size_t stop_count = snapshot.GetStopCount();
+    const std::size_t bus_count = snapshot.GetBusCount();
+    const std::vector<CatalogueSnapshot::Segment>& segments = snapshot.GetSegments();
+
+    /* Каждая задача собирает и пишет свои колонки, читая только неизменяемый снимок */
+    std::vector<std::function<void()>> tasks;
+
+    tasks.push_back([&] {
+        WriteNames(dir, "stops.names", stop_count, [&](std::size_t id) -> const std::string& {
+            return snapshot.GetStop(static_cast<StopId>(id)).name;
+        });
+    });
+    tasks.push_back([&] {
+        WriteColumn(dir / "stops.lat", Collect<double>(stop_count, [&](std::size_t id) {
+            return snapshot.GetStop(static_cast<StopId>(id)).coordinates.lat;
+        }));
+        WriteColumn(dir / "stops.lng", Collect<double>(stop_count, [&](std::size_t id) {
+            return snapshot.GetStop(static_cast<StopId>(id)).coordinates.lng;
+        }));
+    });
+    tasks.push_back([&] {
+        std::vector<std::uint32_t> offsets{ 0 };
+        std::vector<std::uint32_t> buses;
+        for (StopId id = 0; id < stop_count; ++id) {
+            for (BusId bus : snapshot.GetStopBuses(id)) {
+                buses.push_back(bus);
+            }
+            offsets.push_back(static_cast<std::uint32_t>(buses.size()));
+        }
+        WriteColumn(dir / "stops.buses.offsets", offsets);
+        WriteColumn(dir / "stops.buses", buses);
+    });
+    tasks.push_back([&] {
+        WriteNames(dir, "buses.names", bus_count, [&](std::size_t id) -> const std::string& {
+            return snapshot.GetBus(static_cast<BusId>(id)).name;
+        });
+    });
+    tasks.push_back([&] {
+        auto bus = [&](std::size_t id) -> const CatalogueSnapshot::BusRecord& {
+            return snapshot.GetBus(static_cast<BusId>(id));
+        };
+        WriteColumn(dir / "buses.is_roundtrip", Collect<std::uint8_t>(bus_count, [&](std::size_t id) {
+            return bus(id).type == RouteType::Ring;
+        }));
+        WriteColumn(dir / "buses.curvature", Collect<double>(bus_count, [&](std::size_t id) {
+            return bus(id).stats.curvature;
+        }));
+        WriteColumn(dir / "buses.route_length", Collect<std::uint64_t>(bus_count, [&](std::size_t id) {
+            return bus(id).stats.route_length;
+        }));
+        WriteColumn(dir / "buses.stop_count", Collect<std::uint64_t>(bus_count, [&](std::size_t id) {
+            return bus(id).stats.stop_count;
+        }));
+        WriteColumn(dir / "buses.unique_stop_count", Collect<std::uint64_t>(bus_count, [&](std::size_t id) {
+            return bus(id).stats.unique_stop_count;
+        }));
+    });
+    tasks.push_back([&] {
+        std::vector<std::uint32_t> offsets{ 0 };
+        std::vector<std::uint32_t> stops;
+        for (BusId id = 0; id < bus_count; ++id) {
+            for (StopId stop : snapshot.GetBusStops(id)) {
+                stops.push_back(stop);
+            }
+            offsets.push_back(static_cast<std::uint32_t>(stops.size()));
+        }
+        WriteColumn(dir / "buses.stops.offsets", offsets);
+        WriteColumn(dir / "buses.stops", stops);
+    });
+    tasks.push_back([&] {
+        WriteColumn(dir / "segments.from", Collect<std::uint32_t>(segments.size(), [&](std::size_t i) {
+            return segments[i].from;
+        }));
+        WriteColumn(dir / "segments.to", Collect<std::uint32_t>(segments.size(), [&](std::size_t i) {
+            return segments[i].to;
+        }));
+        WriteColumn(dir / "segments.distance", Collect<std::uint64_t>(segments.size(), [&](std::size_t i) {
+            return segments[i].distance;
+        }));
+    });
+    if (router) {
+        tasks.push_back([&] {
+            std::vector<double> times(stop_count * stop_count, std::numeric_limits<double>::quiet_NaN());
+            for (StopId from = 0; from < stop_count; ++from) {
+                for (StopId to = 0; to < stop_count; ++to) {
+                    if (const std::optional<double> time = router->GetTravelTime(from, to)) {
+                        times[std::size_t{from} * stop_count + to] = *time;
+                    }
+                }
+            }
+            WriteColumn(dir / "travel_times", times);
+        });
+    }
+
+    parallel::ForEachChunk(tasks.size(), thread_count, [&](std::size_t, std::size_t begin, std::size_t end) {
+        for (std::size_t i = begin; i < end; ++i) {
+            tasks[i]();
+        }
+    });
+}
+
+} // end Transport
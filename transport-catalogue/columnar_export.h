@@ -0,0 +1,61 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "catalogue_snapshot.h"
+#include "transport_router.h"
+
+namespace Transport {
+
+/*
+* Выгрузка каталога в двоичные колонки: по файлу на колонку.
+*
+* Файл — заголовок ColumnHeader (32 байта) и сразу за ним count значений
+* в порядке байтов машины без разделителей. Данные начинаются с выровненного
+* смещения, поэтому файл можно отобразить в память и читать как массив.
+*
+* Идентификатор остановки или автобуса — индекс в колонках stops.* или buses.*.
+* Переменные по длине данные (имена, списки) — пара колонок: *.offsets с count + 1
+* смещениями и сами значения; элемент i лежит в [offsets[i], offsets[i + 1]).
+*
+*   stops.names.offsets (u64), stops.names (bytes), stops.lat (f64), stops.lng (f64),
+*   stops.buses.offsets (u32), stops.buses (u32: BusId),
+*   buses.names.offsets (u64), buses.names (bytes), buses.is_roundtrip (u8),
+*   buses.curvature (f64), buses.route_length (u64), buses.stop_count (u64),
+*   buses.unique_stop_count (u64), buses.stops.offsets (u32), buses.stops (u32: StopId),
+*   segments.from (u32), segments.to (u32), segments.distance (u64),
+*   travel_times (f64, по желанию): матрица stops x stops по строкам, NaN — маршрута нет.
+*/
+enum class ColumnType : std::uint32_t {
+    U8 = 1,
+    U32 = 2,
+    U64 = 3,
+    F64 = 4,
+    Bytes = 5
+};
+
+struct ColumnHeader {
+    char magic[8];                  // "TCCOL01\0"
+    ColumnType type;
+    std::uint32_t element_size;
+    std::uint64_t count;
+    std::uint64_t reserved;
+};
+
+static_assert(sizeof(ColumnHeader) == 32, "Column header must stay 32 bytes");
+
+/**
+ * Пишет колонки в каталог directory, создавая его при необходимости.
+ * Колонки пишутся параллельно в thread_count потоков. Если router не nullptr,
+ * выгружается и таблица времени в пути. При ошибке записи бросает std::runtime_error.
+*/
+void ExportColumns(
+    const CatalogueSnapshot& snapshot,
+    const Router* router,
+    const std::string& directory,
+    std::size_t thread_count
+);
+
+} // end Transport
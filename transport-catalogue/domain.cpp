@@ -1,14 +1,27 @@
 #include <stddef.h>
+#include <algorithm>
+#include <stdexcept>
+#include <cstring>
+#include <deque>
+#include <iterator>
+#include <type_traits>
+#include <functional>
+#include <limits>
+#include <unordered_map>
 #include <set>
 #include <sstream>
 #include "memory"
+#include "binary_base.h"
 #include "geo.h"
 #include "map_renderer.h"
 #include "svg.h"
 #include <sstream>
 #include <set>
 #include "json.h"
+#include "json_arena.h"
 #include "json_builder.h"
+#include "parallel.h"
+#include "catalogue_snapshot.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 
@@ -16,9 +29,7 @@ namespace domain {
     /*
     * Общие методы сущностей
     */
-    BaseEntity::BaseEntity(const json::Node& node) {
-        node_ = std::make_shared<json::Node>(node);
-    }
+    BaseEntity::BaseEntity(const json::Node& node) : node_(&node) {}
 
     std::string BaseEntity::GetType() const {
         return node_->AsDict().at("type").AsString();
@@ -41,7 +52,7 @@ namespace domain {
     }
 
     const json::Node* BaseEntity::GetNode() const {
-        return node_.get();
+        return node_;
     }
 
     const std::string& Entity::GetName() const { 
@@ -88,6 +99,15 @@ namespace domain {
         return node_->AsDict().at("bus_velocity").AsInt(); 
     }
 
+    /*
+    * Действие пассажира
+    */
+    PassengerAction::PassengerAction(json::Node node) : node_(std::move(node)) {}
+
+    const json::Node* PassengerAction::GetNode() const {
+        return &node_;
+    }
+
 }
 
 namespace domain {
@@ -98,14 +118,24 @@ namespace domain {
    JsonResponses::JsonResponses () : responses_({}) {};
 
     void JsonResponses::Print(std::ostream& out) const {
-        json::Print(
-            json::Document(
-                json::Builder{}
-                .Value(responses_)
-                .Build()
-            ),
-            out
-        );
+        // Вывод Writer с отступами совпадает с json::Print
+        json::Writer writer(out);
+        writer.StartArray();
+        auto map_it = maps_.begin();
+        for (std::size_t i = 0; i < responses_.size(); ++i) {
+            if (map_it == maps_.end() || map_it->index != i) {
+                writer.Value(responses_[i]);
+                continue;
+            }
+            writer.StartDict();
+            writer.Key("map");
+            writer.Raw(map_it->map->data);
+            writer.Key("request_id");
+            writer.Int(map_it->request_id);
+            writer.EndDict();
+            ++map_it;
+        }
+        writer.EndArray();
     }
 
     void JsonResponses::PushBusResponse(
@@ -128,48 +158,79 @@ namespace domain {
         );
     };
 
-    void JsonResponses::PushStopResponse(
-        int request_id,
-        const std::set<std::string_view>& bus_names 
-    ) {
-        json::Builder buses_builder;
-        auto buses = buses_builder.StartArray();
+    namespace {
+        json::Node BusNamesToNode(const BusNamesRange& bus_names) {
+            json::Builder buses_builder;
+            auto buses = buses_builder.StartArray();
 
-        for (auto& bus : bus_names) {
-            buses.Value(std::string(bus));
+            for (auto& bus : bus_names) {
+                buses.Value(std::string(bus));
+            }
+            return buses.EndArray().Build();
         }
+    }
 
+    void JsonResponses::PushStopResponse(
+        int request_id,
+        const BusNamesRange& bus_names 
+    ) {
         responses_.push_back(
                 json::Builder{}
                     .StartDict()
                         .Key("request_id").Value(request_id)
-                        .Key("buses").Value(
-                                buses
-                                    .EndArray()
-                                    .Build()
-                                    .GetValue()
-                            )
+                        .Key("buses").Value(BusNamesToNode(bus_names).GetValue())
                     .EndDict()
                     .Build()
             );
     };
 
-    void JsonResponses::PushMapResponse(
+    void JsonResponses::PushStopSearchResponse(
         int request_id,
-        const svg::Document& svg
+        const std::vector<FoundStop>& stops
     ) {
-        std::ostringstream strm;
-        svg.Render(strm);
+        json::Array found;
+        found.reserve(stops.size());
+        for (const FoundStop& stop : stops) {
+            found.push_back(
+                json::Builder{}
+                    .StartDict()
+                        .Key("name").Value(std::string(stop.name))
+                        .Key("buses").Value(BusNamesToNode(stop.buses).GetValue())
+                    .EndDict()
+                    .Build()
+            );
+        }
         responses_.push_back(
             json::Builder{}
                 .StartDict()
-                    .Key("map")
-                    .Value(strm.str())
-                    .Key("request_id")
-                    .Value(request_id)
+                    .Key("request_id").Value(request_id)
+                    .Key("stops").Value(std::move(found))
                 .EndDict()
                 .Build()
-            );
+        );
+    }
+
+    void JsonResponses::PushDirectResponse(
+        int request_id,
+        const BusNamesRange& bus_names
+    ) {
+        responses_.push_back(
+            json::Builder{}
+                .StartDict()
+                    .Key("request_id").Value(request_id)
+                    .Key("buses").Value(BusNamesToNode(bus_names).GetValue())
+                .EndDict()
+                .Build()
+        );
+    }
+
+    void JsonResponses::PushMapResponse(
+        int request_id,
+        const std::shared_ptr<const Render::RenderedMap>& map
+    ) {
+        // Место ответа; сам ответ пишет Print
+        maps_.push_back({ responses_.size(), request_id, map });
+        responses_.emplace_back(nullptr);
     };
 
     void JsonResponses::PushNotFoundResponse(int request_id) {
@@ -189,6 +250,45 @@ namespace domain {
         );
     }
 
+    namespace {
+        /* Байты в JSON: int, пока значение в него помещается */
+        json::Node BytesToNode(std::size_t bytes) {
+            if (bytes <= static_cast<std::size_t>(std::numeric_limits<int>::max())) {
+                return static_cast<int>(bytes);
+            }
+            return static_cast<double>(bytes);
+        }
+
+        json::Node MemoryUsageToNode(const memory::Usage& usage) {
+            json::Array parts;
+            parts.reserve(usage.parts.size());
+            for (const memory::Usage& part : usage.parts) {
+                parts.push_back(MemoryUsageToNode(part));
+            }
+            return json::Builder{}
+                .StartDict()
+                    .Key("name").Value(usage.name)
+                    .Key("bytes").Value(BytesToNode(usage.GetTotal()).GetValue())
+                    .Key("parts").Value(std::move(parts))
+                .EndDict()
+                .Build();
+        }
+    }
+
+    void JsonResponses::PushMemoryResponse(
+        int request_id,
+        const memory::Usage& usage
+    ) {
+        responses_.push_back(
+            json::Builder{}
+                .StartDict()
+                    .Key("request_id").Value(request_id)
+                    .Key("memory").Value(MemoryUsageToNode(usage).GetValue())
+                .EndDict()
+                .Build()
+        );
+    }
+
     void JsonResponses::PushRouteResponse(
         int request_id,
         double total_time,
@@ -209,6 +309,339 @@ namespace domain {
                 .Build()
         );
     }
+
+    /*
+    * Класс ответов через JSON с записью по мере добавления.
+    * Ключи каждого ответа пишутся по возрастанию, как их упорядочил бы json::Dict.
+    */
+    JsonStreamResponses::JsonStreamResponses(std::ostream& out, JsonLayout layout) :
+        layout_(layout),
+        out_(out),
+        writer_(out_, layout != JsonLayout::Indented) {
+        if (layout_ != JsonLayout::Lines) {
+            writer_.StartArray();
+        }
+    }
+
+    JsonStreamResponses::~JsonStreamResponses() {
+        Finish();
+    }
+
+    void JsonStreamResponses::Print(std::ostream&) const {}
+
+    void JsonStreamResponses::Finish() {
+        if (!finished_) {
+            if (layout_ != JsonLayout::Lines) {
+                writer_.EndArray();
+            }
+            out_.flush();
+            finished_ = true;
+        }
+    }
+
+    void JsonStreamResponses::EndResponse() {
+        if (layout_ == JsonLayout::Lines) {
+            out_.put('\n');
+            out_.flush();
+        }
+    }
+
+    void JsonStreamResponses::WriteBusNames(const BusNamesRange& bus_names) {
+        writer_.StartArray();
+        for (std::string_view bus : bus_names) {
+            writer_.String(bus);
+        }
+        writer_.EndArray();
+    }
+
+    void JsonStreamResponses::PushBusResponse(
+        int request_id,
+        double curvature, 
+        int route_length,
+        int stop_count,
+        int unique_stop_count
+    ) {
+        writer_.StartDict();
+        writer_.Key("curvature");
+        writer_.Double(curvature);
+        writer_.Key("request_id");
+        writer_.Int(request_id);
+        writer_.Key("route_length");
+        writer_.Int(route_length);
+        writer_.Key("stop_count");
+        writer_.Int(stop_count);
+        writer_.Key("unique_stop_count");
+        writer_.Int(unique_stop_count);
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    void JsonStreamResponses::PushStopResponse(
+        int request_id,
+        const BusNamesRange& bus_names 
+    ) {
+        writer_.StartDict();
+        writer_.Key("buses");
+        WriteBusNames(bus_names);
+        writer_.Key("request_id");
+        writer_.Int(request_id);
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    void JsonStreamResponses::PushStopSearchResponse(
+        int request_id,
+        const std::vector<FoundStop>& stops
+    ) {
+        writer_.StartDict();
+        writer_.Key("request_id");
+        writer_.Int(request_id);
+        writer_.Key("stops");
+        writer_.StartArray();
+        for (const FoundStop& stop : stops) {
+            writer_.StartDict();
+            writer_.Key("buses");
+            WriteBusNames(stop.buses);
+            writer_.Key("name");
+            writer_.String(stop.name);
+            writer_.EndDict();
+        }
+        writer_.EndArray();
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    void JsonStreamResponses::PushDirectResponse(
+        int request_id,
+        const BusNamesRange& bus_names
+    ) {
+        writer_.StartDict();
+        writer_.Key("buses");
+        WriteBusNames(bus_names);
+        writer_.Key("request_id");
+        writer_.Int(request_id);
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    void JsonStreamResponses::PushMapResponse(
+        int request_id,
+        const std::shared_ptr<const Render::RenderedMap>& map
+    ) {
+        writer_.StartDict();
+        writer_.Key("map");
+        writer_.Raw(map->data);
+        writer_.Key("request_id");
+        writer_.Int(request_id);
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    void JsonStreamResponses::PushRouteResponse(
+        int request_id,
+        double total_time,
+        json::Array items
+    ) {
+        writer_.StartDict();
+        writer_.Key("items");
+        writer_.StartArray();
+        for (const json::Node& item : items) {
+            writer_.Value(item);
+        }
+        writer_.EndArray();
+        writer_.Key("request_id");
+        writer_.Int(request_id);
+        writer_.Key("total_time");
+        writer_.Double(total_time);
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    void JsonStreamResponses::PushNotFoundResponse(int request_id) {
+        writer_.StartDict();
+        writer_.Key("error_message");
+        writer_.String("not found");
+        writer_.Key("request_id");
+        writer_.Int(request_id);
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    void JsonStreamResponses::PushMemoryResponse(
+        int request_id,
+        const memory::Usage& usage
+    ) {
+        writer_.StartDict();
+        writer_.Key("memory");
+        writer_.Value(MemoryUsageToNode(usage));
+        writer_.Key("request_id");
+        writer_.Int(request_id);
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    void JsonStreamResponses::PushErrorResponse(std::string_view message) {
+        writer_.StartDict();
+        writer_.Key("error_message");
+        writer_.String(message);
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    void JsonStreamResponses::PushBaseVersionResponse(std::uint64_t version) {
+        writer_.StartDict();
+        writer_.Key("base_version");
+        writer_.Raw(std::to_string(version));
+        writer_.EndDict();
+        EndResponse();
+    }
+
+    /*
+    * Класс ответов в двоичном формате
+    */
+    BinaryResponses::BinaryResponses(std::ostream& out) : out_(out) {}
+
+    BinaryResponses::~BinaryResponses() {
+        Finish();
+    }
+
+    void BinaryResponses::Finish() {
+        out_.flush();
+    }
+
+    template <typename T>
+    void BinaryResponses::Put(T value) {
+        static_assert(std::is_trivially_copyable_v<T>, "Only plain values are written as bytes");
+        const std::size_t offset = frame_.size();
+        frame_.resize(offset + sizeof(T));
+        std::memcpy(frame_.data() + offset, &value, sizeof(T));
+    }
+
+    void BinaryResponses::PutString(std::string_view value) {
+        Put(static_cast<std::uint32_t>(value.size()));
+        frame_.append(value);
+    }
+
+    void BinaryResponses::PutBusNames(const BusNamesRange& bus_names) {
+        Put(static_cast<std::uint32_t>(std::distance(bus_names.begin(), bus_names.end())));
+        for (std::string_view bus : bus_names) {
+            PutString(bus);
+        }
+    }
+
+    void BinaryResponses::PutMemoryUsage(const memory::Usage& usage) {
+        PutString(usage.name);
+        Put(static_cast<std::uint64_t>(usage.GetTotal()));
+        Put(static_cast<std::uint32_t>(usage.parts.size()));
+        for (const memory::Usage& part : usage.parts) {
+            PutMemoryUsage(part);
+        }
+    }
+
+    void BinaryResponses::StartFrame(ResponseKind kind, int request_id) {
+        frame_.clear();
+        Put(kind);
+        Put(static_cast<std::int32_t>(request_id));
+    }
+
+    void BinaryResponses::EndFrame() {
+        const std::uint32_t size = static_cast<std::uint32_t>(frame_.size());
+        out_.write(reinterpret_cast<const char*>(&size), sizeof(size));
+        out_.write(frame_.data(), static_cast<std::streamsize>(frame_.size()));
+    }
+
+    void BinaryResponses::PushBusResponse(
+        int request_id,
+        double curvature, 
+        int route_length,
+        int stop_count,
+        int unique_stop_count
+    ) {
+        StartFrame(ResponseKind::Bus, request_id);
+        Put(curvature);
+        Put(static_cast<std::int32_t>(route_length));
+        Put(static_cast<std::int32_t>(stop_count));
+        Put(static_cast<std::int32_t>(unique_stop_count));
+        EndFrame();
+    }
+
+    void BinaryResponses::PushStopResponse(
+        int request_id,
+        const BusNamesRange& bus_names 
+    ) {
+        StartFrame(ResponseKind::Stop, request_id);
+        PutBusNames(bus_names);
+        EndFrame();
+    }
+
+    void BinaryResponses::PushStopSearchResponse(
+        int request_id,
+        const std::vector<FoundStop>& stops
+    ) {
+        StartFrame(ResponseKind::StopSearch, request_id);
+        Put(static_cast<std::uint32_t>(stops.size()));
+        for (const FoundStop& stop : stops) {
+            PutString(stop.name);
+            PutBusNames(stop.buses);
+        }
+        EndFrame();
+    }
+
+    void BinaryResponses::PushDirectResponse(
+        int request_id,
+        const BusNamesRange& bus_names
+    ) {
+        StartFrame(ResponseKind::Direct, request_id);
+        PutBusNames(bus_names);
+        EndFrame();
+    }
+
+    void BinaryResponses::PushMapResponse(
+        int request_id,
+        const std::shared_ptr<const Render::RenderedMap>& map
+    ) {
+        StartFrame(ResponseKind::Map, request_id);
+        PutString(map->data);
+        EndFrame();
+    }
+
+    void BinaryResponses::PushRouteResponse(
+        int request_id,
+        double total_time,
+        json::Array items
+    ) {
+        StartFrame(ResponseKind::Route, request_id);
+        Put(total_time);
+        Put(static_cast<std::uint32_t>(items.size()));
+        for (const json::Node& item : items) {
+            const json::Dict& dict = item.AsDict();
+            if (dict.at("type").AsString() == "Wait") {
+                Put(RouteItemKind::Wait);
+                PutString(dict.at("stop_name").AsString());
+                Put(dict.at("time").AsDouble());
+            } else {
+                Put(RouteItemKind::Bus);
+                PutString(dict.at("bus").AsString());
+                Put(dict.at("time").AsDouble());
+                Put(static_cast<std::int32_t>(dict.at("span_count").AsInt()));
+            }
+        }
+        EndFrame();
+    }
+
+    void BinaryResponses::PushNotFoundResponse(int request_id) {
+        StartFrame(ResponseKind::NotFound, request_id);
+        EndFrame();
+    }
+
+    void BinaryResponses::PushMemoryResponse(
+        int request_id,
+        const memory::Usage& usage
+    ) {
+        StartFrame(ResponseKind::Memory, request_id);
+        PutMemoryUsage(usage);
+        EndFrame();
+    }
 };
 
 namespace domain {
@@ -294,6 +727,31 @@ namespace domain {
         return node_->AsDict().at("underlayer_width").AsDouble();
     }
 
+    Render::RenderSettings Settings::ToRenderSettings() const {
+        Render::RenderSettings render_settings;
+
+        /* Общие настройки */
+        render_settings.width = GetWidth();
+        render_settings.height = GetHeight();
+        render_settings.padding = GetPadding();
+        render_settings.stop_radius = GetRadius();
+        render_settings.line_width = GetLineWidth();
+
+        /* Лейблы */
+        render_settings.bus_label_font_size = GetBusLabelFontSize();
+        const json::Array& bus_label_offset = GetBusLabelOffset();
+        render_settings.bus_label_offset = { bus_label_offset[0].AsDouble(), bus_label_offset[1].AsDouble() };
+        render_settings.stop_label_font_size = GetStopLabelFontSize();
+        const json::Array& stop_label_offset = GetStopLabelOffset();
+        render_settings.stop_label_offset = { stop_label_offset[0].AsDouble(), stop_label_offset[1].AsDouble() };
+
+        /* Подложка */
+        render_settings.underlayer_color = GetUnderlayerColor();
+        render_settings.color_palette = GetPalette();
+        render_settings.underlayer_width = GetUnderlayerWidth();
+        return render_settings;
+    }
+
 }
 
 namespace domain {
@@ -315,8 +773,17 @@ namespace domain {
     /*
     * Класс запросов через JSON
     */
-    JsonRequests::JsonRequests (std::istream& input) : 
-        base_document_(json::Load(input)) {}
+    JsonRequests::JsonRequests (std::istream& input, std::size_t thread_count) : 
+        base_document_(json::Load(input)),
+        thread_count_(std::max<std::size_t>(1, thread_count)) {}
+
+    JsonRequests::JsonRequests (std::string_view input, std::size_t thread_count) : 
+        base_document_(json::Load(input)),
+        thread_count_(std::max<std::size_t>(1, thread_count)) {}
+
+    JsonRequests::JsonRequests (json::Document document, std::size_t thread_count) : 
+        base_document_(std::move(document)),
+        thread_count_(std::max<std::size_t>(1, thread_count)) {}
 
     std::pair<std::vector<BusEntity>, std::vector<StopEntity>> JsonRequests::GetBase() const {
         std::pair<std::vector<BusEntity>, std::vector<StopEntity>> base;
@@ -342,124 +809,812 @@ namespace domain {
         return base_document_.GetRoot().AsDict().at("render_settings");
     };
 
-    domain::RouterSettings JsonRequests::GetRouterSettings() const {
-        return base_document_.GetRoot()
+    Transport::RouterSettings JsonRequests::GetRouterSettings() const {
+        const domain::RouterSettings settings = base_document_.GetRoot()
             .AsDict()
             .at("routing_settings");
+        return { settings.GetBusWaitTime(), settings.GetBusVelocity() };
     };
 
-    void JsonRequests::FillTransportCatalogue(Transport::Catalogue& catalogue) const {
-        using namespace std::literals;
-
-        std::pair<std::vector<domain::BusEntity>, std::vector<domain::StopEntity>> base_requests = GetBase();
-        std::vector<std::tuple<std::string, std::string, std::size_t>> parsed_distances;
+    namespace {
 
         /*
-        * Создание остановок
+        * Запрос на добавление остановки или автобуса над узлом json::Node или
+        * json::arena::Node. Поля словаря разбираются одним проходом в конструкторе,
+        * строки и вложенные словари и массивы остаются ссылками в документ:
+        * ни копий узлов, ни выделений памяти. Узел должен жить дольше представления.
         */
-        for(const domain::StopEntity& request : base_requests.second) {
-            std::string stop_name = request.GetName();
-            Geo::Coordinates coordinates = { request.GetLatitude(), request.GetLongitude() };
-            std::shared_ptr<Transport::Stop> stop_ptr = std::make_shared<Transport::Stop>(stop_name, coordinates);
-            json::Dict distances = request.GetDistances();
-            for (auto& [ adjacent_stop_name, node_distance ] : distances) {
-                std::size_t distance = static_cast<int>(node_distance.AsInt());
-                stop_ptr->AddAdjacent( adjacent_stop_name, distance );
-                parsed_distances.emplace_back(stop_name, adjacent_stop_name, distance);
+        template <typename Node>
+        class BaseRequestView {
+        public:
+            explicit BaseRequestView(const Node& node) {
+                for (const auto& [key, value] : node.AsDict()) {
+                    if (key == "type") {
+                        type_ = value.AsString();
+                    } else if (key == "name") {
+                        name_ = value.AsString();
+                        fields_ |= NAME;
+                    } else if (key == "latitude") {
+                        latitude_ = value.AsDouble();
+                        fields_ |= LATITUDE;
+                    } else if (key == "longitude") {
+                        longitude_ = value.AsDouble();
+                        fields_ |= LONGITUDE;
+                    } else if (key == "road_distances") {
+                        distances_ = &value;
+                    } else if (key == "stops") {
+                        stops_ = &value;
+                    } else if (key == "is_roundtrip") {
+                        is_roundtrip_ = value.AsBool();
+                        fields_ |= IS_ROUNDTRIP;
+                    }
+                }
+                if (IsStop()) {
+                    Require(NAME | LATITUDE | LONGITUDE, distances_ != nullptr);
+                } else {
+                    Require(NAME | IS_ROUNDTRIP, stops_ != nullptr);
+                }
             }
-            catalogue.AddStop(stop_ptr);
-        }
 
-        /**
-         * Создание сегментов дорожной сети
-        */
-        for(auto distance : parsed_distances) {
-            catalogue.SetDistance(std::get<0>(distance), std::get<1>(distance), std::get<2>(distance));
+            bool IsStop() const {
+                return type_ == "Stop";
+            }
+            std::string_view GetName() const {
+                return name_;
+            }
+            double GetLatitude() const {
+                return latitude_;
+            }
+            double GetLongitude() const {
+                return longitude_;
+            }
+            decltype(auto) GetDistances() const {
+                return distances_->AsDict();
+            }
+            decltype(auto) GetStops() const {
+                return stops_->AsArray();
+            }
+            bool IsRoundtrip() const {
+                return is_roundtrip_;
+            }
+
+        private:
+            enum Field : unsigned {
+                NAME = 1,
+                LATITUDE = 2,
+                LONGITUDE = 4,
+                IS_ROUNDTRIP = 8
+            };
+
+            void Require(unsigned fields, bool has_container) const {
+                if ((fields_ & fields) != fields || !has_container) {
+                    throw std::out_of_range("Base request '" + std::string(name_) + "' misses a required field");
+                }
+            }
+
+            std::string_view type_;
+            std::string_view name_;
+            double latitude_ = 0.0;
+            double longitude_ = 0.0;
+            const Node* distances_ = nullptr;
+            const Node* stops_ = nullptr;
+            bool is_roundtrip_ = false;
+            unsigned fields_ = 0;
+        };
+
+        /* Запросы на добавление из массива base_requests, разделённые на остановки и автобусы */
+        template <typename Node, typename Requests>
+        void SplitBaseRequests(
+            const Requests& base_requests,
+            std::vector<BaseRequestView<Node>>& stop_requests,
+            std::vector<BaseRequestView<Node>>& bus_requests
+        ) {
+            stop_requests.reserve(base_requests.size());
+            bus_requests.reserve(base_requests.size());
+            for (const Node& node : base_requests) {
+                BaseRequestView<Node> request(node);
+                (request.IsStop() ? stop_requests : bus_requests).push_back(request);
+            }
         }
 
-        /**
-         * Создание автобусов
+        /*
+        * Наполняет каталог запросами на добавление; StopRequest и BusRequest —
+        * сущности над узлами любого документа с одинаковыми методами.
         */
-        for(const domain::BusEntity& bus: base_requests.first) {
-            Transport::RouteType route_type = bus.IsRoundtrip() ? Transport::RouteType::Ring : Transport::RouteType::Line; 
-            std::shared_ptr<Transport::Bus> bus_ptr = std::make_shared<Transport::Bus>(bus.GetName(), route_type, catalogue);
-            for (const json::Node& stop_name : bus.GetStops()) {
-                std::shared_ptr<Transport::Stop> stop = catalogue.GetStop(stop_name.AsString());
-                bus_ptr->AddStop(stop);
+        template <typename StopRequest, typename BusRequest>
+        void FillCatalogue(
+            const std::vector<StopRequest>& stop_requests,
+            const std::vector<BusRequest>& bus_requests,
+            Transport::Catalogue& catalogue,
+            std::size_t thread_count
+        ) {
+            /*
+            * Каждый этап разбивается на блоки по потокам. Потоки не трогают общих данных,
+            * а результаты сливаются в порядке блоков, то есть в порядке входных запросов,
+            * поэтому каталог получается тем же, что и при последовательной загрузке.
+            */
+            struct ParsedDistance {
+                std::size_t stop_index;
+                std::string_view adjacent_stop_name;
+                std::size_t distance;
+            };
+            const std::size_t stops_chunks = parallel::GetChunkCount(stop_requests.size(), thread_count);
+            std::vector<std::shared_ptr<Transport::Stop>> stops(stop_requests.size());
+            std::vector<std::vector<ParsedDistance>> distance_shards(stops_chunks);
+
+            /*
+            * Создание остановок
+            */
+            parallel::ForEachChunk(stop_requests.size(), thread_count, [&](std::size_t chunk, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    const StopRequest& request = stop_requests[i];
+                    Geo::Coordinates coordinates = { request.GetLatitude(), request.GetLongitude() };
+                    stops[i] = std::make_shared<Transport::Stop>(std::string(request.GetName()), coordinates);
+                    for (auto& [ adjacent_stop_name, node_distance ] : request.GetDistances()) {
+                        std::size_t distance = static_cast<int>(node_distance.AsInt());
+                        stops[i]->AddAdjacent( adjacent_stop_name, distance );
+                        distance_shards[chunk].push_back({ i, adjacent_stop_name, distance });
+                    }
+                }
+            });
+            for (const std::shared_ptr<Transport::Stop>& stop : stops) {
+                catalogue.AddStop(stop);
+            }
+            auto find_stop = [&catalogue](std::string_view name) {
+                std::shared_ptr<Transport::Stop> stop = catalogue.GetStop(name);
+                if (!stop) {
+                    throw std::runtime_error("Unknown stop '" + std::string(name) + "' in base requests");
+                }
+                return stop;
+            };
+
+            /**
+             * Создание сегментов дорожной сети: имена разрешаются параллельно,
+             * запись в каталог идёт по шардам в исходном порядке
+            */
+            struct ResolvedDistance {
+                std::shared_ptr<Transport::Stop> from;
+                std::shared_ptr<Transport::Stop> to;
+                std::size_t distance;
+            };
+            std::vector<std::vector<ResolvedDistance>> resolved_shards(distance_shards.size());
+            parallel::ForEachChunk(distance_shards.size(), thread_count, [&](std::size_t, std::size_t begin, std::size_t end) {
+                for (std::size_t shard = begin; shard < end; ++shard) {
+                    resolved_shards[shard].reserve(distance_shards[shard].size());
+                    for (const ParsedDistance& parsed : distance_shards[shard]) {
+                        resolved_shards[shard].push_back({
+                            stops[parsed.stop_index],
+                            find_stop(parsed.adjacent_stop_name),
+                            parsed.distance
+                        });
+                    }
+                }
+            });
+            for (const std::vector<ResolvedDistance>& shard : resolved_shards) {
+                for (const ResolvedDistance& resolved : shard) {
+                    catalogue.SetDistance(resolved.from, resolved.to, resolved.distance);
+                }
+            }
+
+            /**
+             * Создание автобусов: маршруты, длины и извилистость строятся параллельно,
+             * регистрация автобусов на остановках и в каталоге — последовательно
+            */
+            std::vector<std::shared_ptr<Transport::Bus>> buses(bus_requests.size());
+            parallel::ForEachChunk(bus_requests.size(), thread_count, [&](std::size_t, std::size_t begin, std::size_t end) {
+                for (std::size_t i = begin; i < end; ++i) {
+                    const BusRequest& bus = bus_requests[i];
+                    Transport::RouteType route_type = bus.IsRoundtrip() ? Transport::RouteType::Ring : Transport::RouteType::Line; 
+                    buses[i] = std::make_shared<Transport::Bus>(std::string(bus.GetName()), route_type, catalogue);
+                    for (const auto& stop_name : bus.GetStops()) {
+                        buses[i]->AppendStop(find_stop(stop_name.AsString()));
+                    }
+                    buses[i]->ComputeGeoLength();
+                }
+            });
+            for (const std::shared_ptr<Transport::Bus>& bus : buses) {
+                bus->RegisterOnStops();
+                catalogue.AddBus(bus);
             }
-            catalogue.AddBus(bus_ptr);
         }
+
+    } // namespace
+
+    void JsonRequests::FillTransportCatalogue(Transport::Catalogue& catalogue) const {
+        std::vector<BaseRequestView<json::Node>> stop_requests;
+        std::vector<BaseRequestView<json::Node>> bus_requests;
+        SplitBaseRequests(base_document_.GetRoot().AsDict().at("base_requests").AsArray(), stop_requests, bus_requests);
+        FillCatalogue(stop_requests, bus_requests, catalogue, thread_count_);
+    }
+
+    memory::Usage JsonRequests::GetMemoryUsage() const {
+        return memory::Usage{ "requests", sizeof(JsonRequests), {} }
+            .AddPart("document", memory::GetHeapBytes(base_document_.GetRoot()));
     }
 
     void JsonRequests::FillRenderSettings(Render::RoutesMap& routes_map) const {
-        domain::Settings render_settings = GetRenderSettings();
-        routes_map.AppplySettings(render_settings);
+        routes_map.AppplySettings(GetRenderSettings().ToRenderSettings());
+        routes_map.SetThreadCount(thread_count_);
     };
 
+    std::vector<StatRequest> JsonRequests::GetStatRequests() const {
+        std::vector<StatRequest> stat_requests;
+        for (const json::Node& node : base_document_.GetRoot().AsDict().at("stat_requests").AsArray()) {
+            stat_requests.push_back(ParseStatRequest(node));
+        }
+        return stat_requests;
+    }
+
     void JsonRequests::FillStatResponses(
         domain::IStatResponses& responses, 
         const Transport::Catalogue& catalogue,
         const Render::RoutesMap& routes_map,
         const Transport::Router& router
     ) const {
-        using namespace std::literals;
-        std::vector<domain::Stat> stat_requests = GetStats();
-        for (const domain::Stat& request : stat_requests) {
-            const std::string& type = request.GetType();
-            int request_id = request.GetRequestId();
-            if (type == "Stop") {
-                std::string name = request.GetName();
-                const std::shared_ptr<Transport::Stop> stop = catalogue.GetStop(name);
-                if (stop) {
-                    const std::set<std::string_view>& buses = stop->GetBusNames();
-                    responses.PushStopResponse(
-                        request.GetRequestId(),
-                        buses
-                    );
+        ExecuteStatRequests(GetStatRequests(), *this, responses, catalogue, routes_map, router);
+    }
+
+    /*
+    * Запросы к данным
+    */
+    namespace {
+
+        /* Общий разбор для узлов json::Node и json::arena::Node */
+        template <typename Node>
+        StatRequest DecodeStatRequest(const Node& node) {
+            const auto& dict = node.AsDict();
+            StatRequest request;
+            request.id = dict.at("id").AsInt();
+            request.type = ParseStatType(dict.at("type").AsString());
+            auto read_string = [&dict](const char* key, std::string& value) {
+                if (const auto it = dict.find(key); it != dict.end()) {
+                    value = it->second.AsString();
+                }
+            };
+            read_string("name", request.name);
+            read_string("from", request.from);
+            read_string("to", request.to);
+            read_string("prefix", request.prefix);
+            if (const auto it = dict.find("direct"); it != dict.end()) {
+                request.direct = it->second.AsBool();
+            }
+            if (const auto it = dict.find("limit"); it != dict.end()) {
+                request.limit = std::max(0, it->second.AsInt());
+            }
+            if (const auto it = dict.find("max_edits"); it != dict.end()) {
+                request.max_edits = std::max(0, it->second.AsInt());
+            }
+            return request;
+        }
+
+    } // namespace
+
+    StatType ParseStatType(std::string_view type) {
+        static const std::unordered_map<std::string_view, StatType> types = {
+            { "Stop", StatType::Stop },
+            { "Bus", StatType::Bus },
+            { "StopSearch", StatType::StopSearch },
+            { "Direct", StatType::Direct },
+            { "Map", StatType::Map },
+            { "Memory", StatType::Memory },
+            { "Route", StatType::Route }
+        };
+        const auto it = types.find(type);
+        return it != types.end() ? it->second : StatType::Unknown;
+    }
+
+    StatRequest ParseStatRequest(const json::Node& node) {
+        return DecodeStatRequest(node);
+    }
+
+    std::vector<StatCommand> CompileStatRequests(
+        const std::vector<StatRequest>& requests,
+        const Transport::CatalogueSnapshot& snapshot
+    ) {
+        auto find_stop = [&snapshot](const std::string& name) {
+            return snapshot.FindStop(name).value_or(StatCommand::NOT_FOUND);
+        };
+        auto clamp = [](std::size_t value) {
+            return static_cast<std::uint32_t>(std::min<std::size_t>(value, StatCommand::NOT_FOUND));
+        };
+        std::vector<StatCommand> commands;
+        commands.reserve(requests.size());
+        for (const StatRequest& request : requests) {
+            StatCommand& command = commands.emplace_back();
+            command.type = request.type;
+            command.id = request.id;
+            switch (request.type) {
+                case StatType::Stop:
+                    command.first = find_stop(request.name);
+                    break;
+                case StatType::Bus:
+                    command.first = snapshot.FindBus(request.name).value_or(StatCommand::NOT_FOUND);
+                    break;
+                case StatType::StopSearch:
+                    command.prefix = request.prefix;
+                    command.limit = clamp(request.limit);
+                    command.max_edits = clamp(request.max_edits);
+                    break;
+                case StatType::Route:
+                    command.direct = request.direct;
+                    [[fallthrough]];
+                case StatType::Direct:
+                    command.first = find_stop(request.from);
+                    command.second = find_stop(request.to);
+                    break;
+                case StatType::Map:
+                case StatType::Memory:
+                case StatType::Unknown:
+                    break;
+            }
+        }
+        return commands;
+    }
+
+    template <typename Responses>
+    void ExecuteStatRequests(
+        const std::vector<StatRequest>& requests,
+        const IRequests& source,
+        Responses& responses,
+        const Transport::Catalogue& catalogue,
+        const Render::RoutesMap& routes_map,
+        const Transport::Router& router
+    ) {
+        // Запросы к данным читают только неизменяемый снимок; маршрутизатор построен по нему же
+        const std::shared_ptr<const Transport::CatalogueSnapshot> snapshot_ptr = catalogue.GetSnapshot();
+        const Transport::CatalogueSnapshot& snapshot = *snapshot_ptr;
+        for (const StatCommand& command : CompileStatRequests(requests, snapshot)) {
+            const int request_id = command.id;
+            switch (command.type) {
+                case StatType::Stop:
+                    if (command.first == StatCommand::NOT_FOUND) {
+                        break;
+                    }
+                    responses.PushStopResponse(request_id, snapshot.GetStopBusNames(command.first));
                     continue;
-                } 
-            } else if (type == "Bus") {
-                const std::shared_ptr<Transport::Bus> bus = catalogue.GetBus(request.GetName());
-                if (bus) {
+                case StatType::Bus: {
+                    if (command.first == StatCommand::NOT_FOUND) {
+                        break;
+                    }
+                    const Transport::BusStats& stats = snapshot.GetBus(command.first).stats;
                     responses.PushBusResponse(
-                        request.GetRequestId(),
-                        bus->GetCurvature(),
-                        bus->GetRouteLength(),
-                        bus->GetRouteSize(),
-                        bus->GetUniqueStopsSize()
+                        request_id,
+                        stats.curvature,
+                        stats.route_length,
+                        stats.stop_count,
+                        stats.unique_stop_count
                     );
                     continue;
-                } 
-            } else if (type == "Map") {
-                svg::Document result_svg;
-                routes_map.FillSVG(result_svg, catalogue);
-                responses.PushMapResponse(
-                    request_id,
-                    result_svg
-                );
-                continue;
-            } else if (type == "Route") {
-                const std::string from_stop = request.GetNode()->AsDict().at("from").AsString();
-                const std::string to_stop = request.GetNode()->AsDict().at("to").AsString();
-                std::optional<graph::Router<double>::RouteInfo> route = router.FindRoute(from_stop, to_stop);
-                if (!route) {
-                    responses.PushNotFoundResponse(request_id);
+                }
+                case StatType::StopSearch: {
+                    std::vector<domain::FoundStop> found;
+                    for (Transport::StopId stop : snapshot.GetStopNameIndex().Search(command.prefix, command.limit, command.max_edits)) {
+                        found.push_back({ snapshot.GetStop(stop).name, snapshot.GetStopBusNames(stop) });
+                    }
+                    responses.PushStopSearchResponse(request_id, found);
                     continue;
                 }
-                const std::pair<std::vector<domain::PassengerAction>, double> route_info = router.GetRoute(route.value());
-                json::Array items;
-                for(auto item : route_info.first) {
-                    items.push_back(*item.GetNode());
+                case StatType::Direct: {
+                    if (command.first == StatCommand::NOT_FOUND || command.second == StatCommand::NOT_FOUND) {
+                        break;
+                    }
+                    std::vector<std::string_view> bus_names;
+                    for (Transport::BusId bus : snapshot.GetDirectBuses(command.first, command.second)) {
+                        bus_names.push_back(snapshot.GetBus(bus).name);
+                    }
+                    responses.PushDirectResponse(request_id, ranges::AsRange(bus_names));
+                    continue;
                 }
-                responses.PushRouteResponse(
-                    request.GetRequestId(),
-                    route_info.second,
-                    items
-                );
-                continue;
+                case StatType::Map:
+                    // Карта отрисовывается один раз на снимок, дальше ответы берут готовую
+                    responses.PushMapResponse(request_id, routes_map.GetRenderedMap(snapshot_ptr, Responses::MAP_FORMAT));
+                    continue;
+                case StatType::Memory: {
+                    memory::Usage usage{ "total", 0, {} };
+                    usage.AddPart(source.GetMemoryUsage())
+                        .AddPart(catalogue.GetMemoryUsage())
+                        .AddPart(routes_map.GetMemoryUsage())
+                        .AddPart(router.GetMemoryUsage());
+                    responses.PushMemoryResponse(request_id, usage);
+                    continue;
+                }
+                case StatType::Route: {
+                    if (command.first == StatCommand::NOT_FOUND || command.second == StatCommand::NOT_FOUND) {
+                        break;
+                    }
+                    // "direct": true — только маршруты без пересадок; битовые множества снимка отсекают лишь их
+                    std::optional<graph::Router<double>::RouteInfo> route = command.direct
+                        ? router.FindDirectRoute(command.first, command.second)
+                        : router.FindRoute(command.first, command.second);
+                    if (!route) {
+                        break;
+                    }
+                    const std::pair<std::vector<domain::PassengerAction>, double> route_info = router.GetRoute(route.value());
+                    json::Array items;
+                    for (const domain::PassengerAction& item : route_info.first) {
+                        items.push_back(*item.GetNode());
+                    }
+                    responses.PushRouteResponse(
+                        request_id,
+                        route_info.second,
+                        items
+                    );
+                    continue;
+                }
+                case StatType::Unknown:
+                    break;
             }
             responses.PushNotFoundResponse(request_id);
         }
     }
 
-}
\ No newline at end of file
+    /* Цикл запросов для каждого приёмника ответов */
+    template void ExecuteStatRequests<IStatResponses>(
+        const std::vector<StatRequest>&, const IRequests&, IStatResponses&,
+        const Transport::Catalogue&, const Render::RoutesMap&, const Transport::Router&);
+    template void ExecuteStatRequests<JsonResponses>(
+        const std::vector<StatRequest>&, const IRequests&, JsonResponses&,
+        const Transport::Catalogue&, const Render::RoutesMap&, const Transport::Router&);
+    template void ExecuteStatRequests<JsonStreamResponses>(
+        const std::vector<StatRequest>&, const IRequests&, JsonStreamResponses&,
+        const Transport::Catalogue&, const Render::RoutesMap&, const Transport::Router&);
+    template void ExecuteStatRequests<BinaryResponses>(
+        const std::vector<StatRequest>&, const IRequests&, BinaryResponses&,
+        const Transport::Catalogue&, const Render::RoutesMap&, const Transport::Router&);
+    template void ExecuteStatRequests<NullResponses>(
+        const std::vector<StatRequest>&, const IRequests&, NullResponses&,
+        const Transport::Catalogue&, const Render::RoutesMap&, const Transport::Router&);
+
+    /*
+    * Класс запросов через JSON без документа
+    */
+    StreamingJsonRequests::StreamingJsonRequests(std::string_view input) {
+        json::ForEachMember(input, [this](std::string_view key, std::string_view value) {
+            if (key == "base_requests") {
+                base_requests_ = value;
+            } else if (key == "stat_requests") {
+                stat_requests_ = value;
+            } else if (key == "render_settings") {
+                // Настройки держат ссылку на узел: документ живёт до конца ветки
+                const json::Document document = json::Load(value);
+                render_settings_ = domain::Settings(document.GetRoot()).ToRenderSettings();
+            } else if (key == "routing_settings") {
+                const json::Document document = json::Load(value);
+                const domain::RouterSettings settings(document.GetRoot());
+                router_settings_ = { settings.GetBusWaitTime(), settings.GetBusVelocity() };
+            }
+        });
+    }
+
+    Transport::RouterSettings StreamingJsonRequests::GetRouterSettings() const {
+        return router_settings_;
+    }
+
+    void StreamingJsonRequests::FillTransportCatalogue(Transport::Catalogue& catalogue) const {
+        /*
+        * Остановки добавляются сразу. Расстояния и автобусы ссылаются на остановки,
+        * которые могут идти позже, поэтому откладываются и применяются
+        * в порядке входных запросов — каталог тот же, что и у JsonRequests.
+        * Отложенное хранит номера остановок, а не копии имён: имя копируется
+        * один раз на остановку, и то лишь если на неё сослались до её объявления.
+        */
+        struct PendingDistance {
+            std::uint32_t from;
+            std::uint32_t to;
+            std::size_t distance;
+        };
+        struct PendingBus {
+            std::string name;
+            Transport::RouteType route_type;
+            std::uint32_t stops_begin;
+            std::uint32_t stops_count;
+        };
+        std::vector<PendingDistance> distances;
+        std::vector<PendingBus> buses;
+        std::vector<std::uint32_t> bus_stops;
+
+        // По номеру: остановка или nullptr, пока она не объявлена
+        std::vector<std::shared_ptr<Transport::Stop>> stops;
+        // Ключи — имена из остановок или из forward_names
+        std::unordered_map<std::string_view, std::uint32_t> stop_ids;
+        // Имена остановок, на которые сослались до объявления
+        std::deque<std::string> forward_names;
+        auto get_stop_id = [&](std::string_view name) {
+            if (auto it = stop_ids.find(name); it != stop_ids.end()) {
+                return it->second;
+            }
+            const auto id = static_cast<std::uint32_t>(stops.size());
+            stops.emplace_back();
+            stop_ids.emplace(forward_names.emplace_back(name), id);
+            return id;
+        };
+
+        auto add_request = [&](const json::Node& node) {
+            const BaseRequestView<json::Node> request(node);
+            if (request.IsStop()) {
+                Geo::Coordinates coordinates = { request.GetLatitude(), request.GetLongitude() };
+                auto stop = std::make_shared<Transport::Stop>(std::string(request.GetName()), coordinates);
+                std::uint32_t id = 0;
+                if (auto it = stop_ids.find(stop->GetName()); it != stop_ids.end()) {
+                    id = it->second;
+                } else {
+                    id = static_cast<std::uint32_t>(stops.size());
+                    stops.emplace_back();
+                    stop_ids.emplace(stop->GetName(), id);
+                }
+                stops[id] = stop;
+                for (auto& [ adjacent_stop_name, node_distance ] : request.GetDistances()) {
+                    std::size_t distance = static_cast<int>(node_distance.AsInt());
+                    distances.push_back({ id, get_stop_id(adjacent_stop_name), distance });
+                }
+                catalogue.AddStop(stop);
+            } else {
+                PendingBus& bus = buses.emplace_back();
+                bus.name = request.GetName();
+                bus.route_type = request.IsRoundtrip() ? Transport::RouteType::Ring : Transport::RouteType::Line;
+                bus.stops_begin = static_cast<std::uint32_t>(bus_stops.size());
+                for (const json::Node& stop_name : request.GetStops()) {
+                    bus_stops.push_back(get_stop_id(stop_name.AsString()));
+                }
+                bus.stops_count = static_cast<std::uint32_t>(bus_stops.size() - bus.stops_begin);
+            }
+        };
+        if (!base_requests_.empty()) {
+            json::ForEachItem(base_requests_, add_request);
+        }
+
+        for (const auto& [ name, id ] : stop_ids) {
+            if (!stops[id]) {
+                throw std::runtime_error("Unknown stop '" + std::string(name) + "' in base requests");
+            }
+        }
+        /*
+        * Сначала собственные расстояния каждой остановки, затем обратные направления:
+        * при повторе остаётся первое, как у JsonRequests. Ключи — имена из самих остановок.
+        */
+        for (const PendingDistance& pending : distances) {
+            std::size_t distance = pending.distance;
+            stops[pending.from]->AddAdjacent(stops[pending.to]->GetName(), distance);
+        }
+        for (const PendingDistance& pending : distances) {
+            catalogue.SetDistance(stops[pending.from], stops[pending.to], pending.distance);
+        }
+        for (const PendingBus& pending : buses) {
+            auto bus = std::make_shared<Transport::Bus>(pending.name, pending.route_type, catalogue);
+            for (std::uint32_t i = pending.stops_begin; i < pending.stops_begin + pending.stops_count; ++i) {
+                bus->AppendStop(stops[bus_stops[i]]);
+            }
+            bus->ComputeGeoLength();
+            bus->RegisterOnStops();
+            catalogue.AddBus(bus);
+        }
+    }
+
+    void StreamingJsonRequests::FillRenderSettings(Render::RoutesMap& routes_map) const {
+        routes_map.AppplySettings(render_settings_);
+    }
+
+    std::vector<StatRequest> StreamingJsonRequests::GetStatRequests() const {
+        std::vector<StatRequest> requests;
+        VisitStatRequests([&requests](const std::vector<StatRequest>& batch) {
+            requests.insert(requests.end(), batch.begin(), batch.end());
+        });
+        return requests;
+    }
+
+    void StreamingJsonRequests::VisitStatRequests(const StatRequestsVisitor& visitor) const {
+        if (stat_requests_.empty()) {
+            return;
+        }
+        std::vector<StatRequest> batch;
+        batch.reserve(STAT_REQUESTS_BATCH);
+        json::ForEachItem(stat_requests_, [&](const json::Node& node) {
+            batch.push_back(ParseStatRequest(node));
+            if (batch.size() == STAT_REQUESTS_BATCH) {
+                visitor(batch);
+                batch.clear();
+            }
+        });
+        if (!batch.empty()) {
+            visitor(batch);
+        }
+    }
+
+    void StreamingJsonRequests::FillStatResponses(
+        domain::IStatResponses& responses, 
+        const Transport::Catalogue& catalogue,
+        const Render::RoutesMap& routes_map,
+        const Transport::Router& router
+    ) const {
+        VisitStatRequests([&](const std::vector<StatRequest>& batch) {
+            ExecuteStatRequests(batch, *this, responses, catalogue, routes_map, router);
+        });
+    }
+
+    memory::Usage StreamingJsonRequests::GetMemoryUsage() const {
+        return memory::Usage{ "requests", sizeof(StreamingJsonRequests), {} }
+            .AddPart("render_settings", memory::GetHeapBytes(render_settings_.color_palette));
+    }
+
+    /*
+    * Класс запросов через JSON с документом в арене
+    */
+    ArenaJsonRequests::ArenaJsonRequests(std::string_view input, std::size_t thread_count) :
+        document_(input),
+        thread_count_(std::max<std::size_t>(1, thread_count)) {}
+
+    Transport::RouterSettings ArenaJsonRequests::GetRouterSettings() const {
+        const json::arena::Dict settings = document_.GetRoot().AsDict().at("routing_settings").AsDict();
+        return { settings.at("bus_wait_time").AsInt(), settings.at("bus_velocity").AsInt() };
+    }
+
+    void ArenaJsonRequests::FillTransportCatalogue(Transport::Catalogue& catalogue) const {
+        std::vector<BaseRequestView<json::arena::Node>> stop_requests;
+        std::vector<BaseRequestView<json::arena::Node>> bus_requests;
+        SplitBaseRequests(document_.GetRoot().AsDict().at("base_requests").AsArray(), stop_requests, bus_requests);
+        FillCatalogue(stop_requests, bus_requests, catalogue, thread_count_);
+    }
+
+    void ArenaJsonRequests::FillRenderSettings(Render::RoutesMap& routes_map) const {
+        // Настройки карты невелики: читаются через обычный узел
+        const json::Node settings = document_.GetRoot().AsDict().at("render_settings").ToNode();
+        routes_map.AppplySettings(domain::Settings(settings).ToRenderSettings());
+        routes_map.SetThreadCount(thread_count_);
+    }
+
+    std::vector<StatRequest> ArenaJsonRequests::GetStatRequests() const {
+        std::vector<StatRequest> stat_requests;
+        for (const json::arena::Node& node : document_.GetRoot().AsDict().at("stat_requests").AsArray()) {
+            stat_requests.push_back(DecodeStatRequest(node));
+        }
+        return stat_requests;
+    }
+
+    void ArenaJsonRequests::FillStatResponses(
+        domain::IStatResponses& responses, 
+        const Transport::Catalogue& catalogue,
+        const Render::RoutesMap& routes_map,
+        const Transport::Router& router
+    ) const {
+        ExecuteStatRequests(GetStatRequests(), *this, responses, catalogue, routes_map, router);
+    }
+
+    memory::Usage ArenaJsonRequests::GetMemoryUsage() const {
+        return memory::Usage{ "requests", sizeof(ArenaJsonRequests), {} }
+            .AddPart("document", document_.GetArenaBytes());
+    }
+
+    /*
+    * Двоичная база
+    */
+    void JsonRequests::WriteBinaryBase(std::ostream& out) const {
+        std::vector<BaseRequestView<json::Node>> stop_requests;
+        std::vector<BaseRequestView<json::Node>> bus_requests;
+        SplitBaseRequests(base_document_.GetRoot().AsDict().at("base_requests").AsArray(), stop_requests, bus_requests);
+
+        // Как в каталоге: при повторе имени действует последняя остановка
+        std::unordered_map<std::string_view, std::uint32_t> stop_indices;
+        for (std::size_t i = 0; i < stop_requests.size(); ++i) {
+            stop_indices[stop_requests[i].GetName()] = static_cast<std::uint32_t>(i);
+        }
+        auto find_stop = [&stop_indices](std::string_view name) {
+            const auto it = stop_indices.find(name);
+            if (it == stop_indices.end()) {
+                throw std::runtime_error("Unknown stop '" + std::string(name) + "' in base requests");
+            }
+            return it->second;
+        };
+
+        binary::BaseWriter writer;
+        std::vector<binary::DistanceRecord> distances;
+        for (const BaseRequestView<json::Node>& stop : stop_requests) {
+            distances.clear();
+            for (const auto& [adjacent_stop_name, node_distance] : stop.GetDistances()) {
+                binary::DistanceRecord distance{};
+                distance.to = find_stop(adjacent_stop_name);
+                distance.distance = static_cast<std::size_t>(static_cast<int>(node_distance.AsInt()));
+                distances.push_back(distance);
+            }
+            writer.AddStop(stop.GetName(), stop.GetLatitude(), stop.GetLongitude(), distances);
+        }
+        std::vector<std::uint32_t> route;
+        for (const BaseRequestView<json::Node>& bus : bus_requests) {
+            route.clear();
+            for (const json::Node& stop_name : bus.GetStops()) {
+                route.push_back(find_stop(stop_name.AsString()));
+            }
+            writer.AddBus(bus.GetName(), bus.IsRoundtrip(), route);
+        }
+        writer.SetSettings(GetRenderSettings().ToRenderSettings(), GetRouterSettings());
+        writer.Write(out);
+    }
+
+    /*
+    * Класс запросов с двоичной базой
+    */
+    BinaryRequests::BinaryRequests(std::string_view base, std::vector<StatRequest> stat_requests, std::size_t thread_count) :
+        base_(base),
+        stat_requests_(std::move(stat_requests)),
+        thread_count_(std::max<std::size_t>(1, thread_count)) {}
+
+    Transport::RouterSettings BinaryRequests::GetRouterSettings() const {
+        return base_.GetRouterSettings();
+    }
+
+    std::vector<StatRequest> BinaryRequests::GetStatRequests() const {
+        return stat_requests_;
+    }
+
+    void BinaryRequests::FillTransportCatalogue(Transport::Catalogue& catalogue) const {
+        /*
+        * Порядок тот же, что у FillCatalogue: остановки с собственными расстояниями,
+        * сегменты дорожной сети, затем автобусы. Имена уже разрешены в индексы.
+        */
+        const std::size_t stop_count = base_.GetStopCount();
+        std::vector<std::shared_ptr<Transport::Stop>> stops(stop_count);
+        for (std::size_t i = 0; i < stop_count; ++i) {
+            const binary::StopRecord record = base_.GetStop(i);
+            Geo::Coordinates coordinates = { record.latitude, record.longitude };
+            stops[i] = std::make_shared<Transport::Stop>(std::string(base_.GetString(record.name)), coordinates);
+        }
+        for (std::size_t i = 0; i < stop_count; ++i) {
+            const binary::StopRecord record = base_.GetStop(i);
+            for (std::uint32_t d = 0; d < record.distances_count; ++d) {
+                const binary::DistanceRecord distance = base_.GetDistance(record.distances_begin + d);
+                std::size_t value = distance.distance;
+                stops[i]->AddAdjacent(stops[distance.to]->GetName(), value);
+            }
+            catalogue.AddStop(stops[i]);
+        }
+        for (std::size_t i = 0; i < stop_count; ++i) {
+            const binary::StopRecord record = base_.GetStop(i);
+            for (std::uint32_t d = 0; d < record.distances_count; ++d) {
+                const binary::DistanceRecord distance = base_.GetDistance(record.distances_begin + d);
+                catalogue.SetDistance(stops[i], stops[distance.to], distance.distance);
+            }
+        }
+
+        std::vector<std::shared_ptr<Transport::Bus>> buses(base_.GetBusCount());
+        parallel::ForEachChunk(buses.size(), thread_count_, [&](std::size_t, std::size_t begin, std::size_t end) {
+            for (std::size_t i = begin; i < end; ++i) {
+                const binary::BusRecord record = base_.GetBus(i);
+                Transport::RouteType route_type = record.is_roundtrip ? Transport::RouteType::Ring : Transport::RouteType::Line; 
+                buses[i] = std::make_shared<Transport::Bus>(std::string(base_.GetString(record.name)), route_type, catalogue);
+                for (std::uint32_t s = 0; s < record.stops_count; ++s) {
+                    buses[i]->AppendStop(stops[base_.GetBusStop(record.stops_begin + s)]);
+                }
+                buses[i]->ComputeGeoLength();
+            }
+        });
+        for (const std::shared_ptr<Transport::Bus>& bus : buses) {
+            bus->RegisterOnStops();
+            catalogue.AddBus(bus);
+        }
+    }
+
+    void BinaryRequests::FillRenderSettings(Render::RoutesMap& routes_map) const {
+        routes_map.AppplySettings(base_.GetRenderSettings());
+        routes_map.SetThreadCount(thread_count_);
+    }
+
+    void BinaryRequests::FillStatResponses(
+        domain::IStatResponses& responses, 
+        const Transport::Catalogue& catalogue,
+        const Render::RoutesMap& routes_map,
+        const Transport::Router& router
+    ) const {
+        ExecuteStatRequests(stat_requests_, *this, responses, catalogue, routes_map, router);
+    }
+
+    memory::Usage BinaryRequests::GetMemoryUsage() const {
+        std::size_t stat_bytes = memory::GetHeapBytes(stat_requests_);
+        for (const StatRequest& request : stat_requests_) {
+            stat_bytes += memory::GetHeapBytes(request.name)
+                + memory::GetHeapBytes(request.from) + memory::GetHeapBytes(request.to)
+                + memory::GetHeapBytes(request.prefix);
+        }
+        // Сама база лежит в буфере вызывающего, например в отображённом файле
+        return memory::Usage{ "requests", sizeof(BinaryRequests), {} }
+            .AddPart("stat_requests", stat_bytes);
+    }
+}
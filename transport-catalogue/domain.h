@@ -1,12 +1,20 @@
 #pragma once
 
+#include <cstdint>
+#include <functional>
+#include <limits>
 #include "memory"
 #include <set>
 #include <sstream>
+#include "binary_base.h"
 #include "json.h"
+#include "json_arena.h"
 #include "svg.h"
 #include "set"
 #include "json_builder.h"
+#include "memory_usage.h"
+#include "output_buffer.h"
+#include "ranges.h"
 
 namespace Render {
 
@@ -25,6 +33,23 @@ struct RenderSettings {
 	std::vector<svg::Color> color_palette {};
 };
 
+/* Вид готовой карты */
+enum class MapFormat {
+	// Документ SVG как есть
+	Svg,
+	// Тот же документ литералом JSON: в кавычках и с экранированием
+	Json
+};
+
+/*
+* Карта, один раз отрисованная для снимка каталога в одном из видов. Ответы Map
+* выводят эти байты без повторной отрисовки и экранирования.
+*/
+struct RenderedMap {
+	MapFormat format;
+	std::string data;
+};
+
 class RoutesMap;
 
 class SphereProjector;
@@ -35,6 +60,7 @@ namespace Transport {
     class Stop;
     class Bus;
     class Catalogue;
+    class CatalogueSnapshot;
 
     struct RouterSettings {
         int bus_wait_time;
@@ -46,11 +72,16 @@ namespace domain {
 
     enum class EntityType { Stop, Bus, Map };
 
-    /* Общий класс для всех сущностей и запросов (карта, автобус, остановка). */
+    /*
+    * Общий класс для всех сущностей и запросов (карта, автобус, остановка).
+    * Не владеет узлом и не копирует его: узел документа должен жить дольше сущности.
+    */
     class BaseEntity {
     public:
 
         [[nodiscard]] BaseEntity(const json::Node& node);
+        /* Сущность над временным узлом сразу бы повисла */
+        BaseEntity(json::Node&& node) = delete;
 
         std::string GetType() const;
 
@@ -65,7 +96,7 @@ namespace domain {
         const json::Node* GetNode() const;
 
     protected:
-        std::shared_ptr<json::Node> node_;
+        const json::Node* node_;
     };
 }
 
@@ -106,16 +137,29 @@ namespace domain {
         int GetBusVelocity() const; 
     };
 
-    /* Действие пассажира */
-    class PassengerAction : public BaseEntity {
+    /* Действие пассажира: узел строится маршрутизатором, поэтому хранится в самом действии */
+    class PassengerAction {
     public:
-        using BaseEntity::BaseEntity;
+        explicit PassengerAction(json::Node node);
+
+        const json::Node* GetNode() const;
+
+    private:
+        json::Node node_;
     };
 
 }
 
 namespace domain {
 
+    /* Отсортированные имена автобусов остановки */
+    using BusNamesRange = ranges::Range<std::vector<std::string_view>::const_iterator>;
+
+    /* Остановка, найденная поиском по имени, с теми же данными, что и ответ "Stop" */
+    struct FoundStop {
+        std::string_view name;
+        BusNamesRange buses;
+    };
 
     /* Интерфейс класса oтветов */
     class IStatResponses {
@@ -131,12 +175,26 @@ namespace domain {
 
         virtual void PushStopResponse(
             int request_id,
-            const std::set<std::string_view>& buses 
+            const BusNamesRange& buses 
         ) = 0;
 
+        virtual void PushStopSearchResponse(
+            int request_id,
+            const std::vector<FoundStop>& stops
+        ) = 0;
+
+        /* Автобусы, соединяющие две остановки без пересадок */
+        virtual void PushDirectResponse(
+            int request_id,
+            const BusNamesRange& buses
+        ) = 0;
+
+        /* Вид карты, который выводит приёмник */
+        static constexpr Render::MapFormat MAP_FORMAT = Render::MapFormat::Json;
+
         virtual void PushMapResponse(
             int request_id,
-            const svg::Document& svg
+            const std::shared_ptr<const Render::RenderedMap>& map
         ) = 0;
 
         virtual void PushRouteResponse(
@@ -147,11 +205,16 @@ namespace domain {
 
         virtual void PushNotFoundResponse(int request_id) = 0;
 
+        virtual void PushMemoryResponse(
+            int request_id,
+            const memory::Usage& usage
+        ) = 0;
+
         virtual ~IStatResponses() = default;
     };
 
     /* Класс ответов через JSON */
-    class JsonResponses : public IStatResponses  {
+    class JsonResponses final : public IStatResponses  {
     public:
 
         explicit JsonResponses ();
@@ -168,12 +231,22 @@ namespace domain {
 
         void PushStopResponse(
             int requestId,
-            const std::set<std::string_view>& bus_names 
+            const BusNamesRange& bus_names 
+        ) override;
+
+        void PushStopSearchResponse(
+            int request_id,
+            const std::vector<FoundStop>& stops
+        ) override;
+
+        void PushDirectResponse(
+            int request_id,
+            const BusNamesRange& buses
         ) override;
 
         void PushMapResponse(
             int request_id,
-            const svg::Document& svg
+            const std::shared_ptr<const Render::RenderedMap>& map
         ) override;
 
         void PushRouteResponse(
@@ -184,8 +257,259 @@ namespace domain {
 
         void PushNotFoundResponse(int request_id) override;
 
+        void PushMemoryResponse(
+            int request_id,
+            const memory::Usage& usage
+        ) override;
+
     private:
+        /* Ответ Map: место в responses_ и общая готовая карта */
+        struct MapResponse {
+            std::size_t index;
+            int request_id;
+            std::shared_ptr<const Render::RenderedMap> map;
+        };
+
         json::Array responses_;
+        // Карты не копируются в узлы: Print выводит их готовый литерал
+        std::vector<MapResponse> maps_;
+    };
+
+    /* Вид вывода JsonStreamResponses */
+    enum class JsonLayout {
+        // Массив ответов с отступами, как у JsonResponses
+        Indented,
+        // Массив ответов без пробелов и переводов строк
+        Compact,
+        // NDJSON: каждый ответ — отдельная компактная строка, сбрасываемая сразу
+        Lines
+    };
+
+    /*
+    * Класс ответов через JSON, который пишет каждый ответ в буферизованный поток
+    * сразу при добавлении. Память не зависит от числа ответов.
+    * Массив закрывается в Finish или в деструкторе.
+    */
+    class JsonStreamResponses final : public IStatResponses {
+    public:
+        explicit JsonStreamResponses(std::ostream& out, JsonLayout layout = JsonLayout::Indented);
+        ~JsonStreamResponses() override;
+
+        /* Ответы уже записаны по мере добавления: Print ничего не выводит */
+        void Print(std::ostream& out) const override;
+
+        /* Закрывает массив ответов и сбрасывает буфер */
+        void Finish();
+
+        void PushBusResponse(
+            int request_id,
+            double curvature, 
+            int route_length,
+            int stop_count,
+            int unique_stop_count
+        ) override;
+
+        void PushStopResponse(
+            int request_id,
+            const BusNamesRange& bus_names 
+        ) override;
+
+        void PushStopSearchResponse(
+            int request_id,
+            const std::vector<FoundStop>& stops
+        ) override;
+
+        void PushDirectResponse(
+            int request_id,
+            const BusNamesRange& buses
+        ) override;
+
+        void PushMapResponse(
+            int request_id,
+            const std::shared_ptr<const Render::RenderedMap>& map
+        ) override;
+
+        void PushRouteResponse(
+            int request_id,
+            double total_time,
+            json::Array items
+        ) override;
+
+        void PushNotFoundResponse(int request_id) override;
+
+        void PushMemoryResponse(
+            int request_id,
+            const memory::Usage& usage
+        ) override;
+
+        /* Ответ на запрос, который не удалось разобрать: {"error_message": message} */
+        void PushErrorResponse(std::string_view message);
+
+        /* Ответ на обновление базы: {"base_version": version} — номер опубликованной версии */
+        void PushBaseVersionResponse(std::uint64_t version);
+
+    private:
+        void WriteBusNames(const BusNamesRange& bus_names);
+        /* Завершает ответ; в NDJSON — переводом строки и сбросом буфера */
+        void EndResponse();
+
+        JsonLayout layout_;
+        io::BufferedOutput out_;
+        json::Writer writer_;
+        bool finished_ = false;
+    };
+
+    /* Вид ответа в двоичном формате */
+    enum class ResponseKind : std::uint8_t {
+        Bus = 1,
+        Stop = 2,
+        StopSearch = 3,
+        Direct = 4,
+        Map = 5,
+        Route = 6,
+        NotFound = 7,
+        Memory = 8
+    };
+
+    /* Вид шага маршрута в двоичном формате */
+    enum class RouteItemKind : std::uint8_t {
+        Wait = 0,
+        Bus = 1
+    };
+
+    /*
+    * Класс ответов в двоичном формате для внутренних клиентов. Ответы пишутся
+    * по мере добавления, как у JsonStreamResponses.
+    *
+    * Поток — последовательность кадров: u32 длина тела и само тело. Числа
+    * в порядке байтов машины, как в выгрузке колонок. Тело — u8 ResponseKind,
+    * i32 request_id и поля вида:
+    *   Bus:        f64 curvature, i32 route_length, i32 stop_count, i32 unique_stop_count
+    *   Stop:       u32 n, n строк — автобусы
+    *   StopSearch: u32 n, n раз: строка — имя, u32 m, m строк — автобусы
+    *   Direct:     как Stop
+    *   Map:        строка — SVG
+    *   Route:      f64 total_time, u32 n, n раз: u8 RouteItemKind, строка — остановка
+    *               или автобус, f64 time, для Bus ещё i32 span_count
+    *   NotFound:   нет полей
+    *   Memory:     узел: строка — имя, u64 байты, u32 n, n дочерних узлов
+    * Строка — u32 длина и байты UTF-8 без завершающего нуля.
+    */
+    class BinaryResponses {
+    public:
+        static constexpr Render::MapFormat MAP_FORMAT = Render::MapFormat::Svg;
+
+        explicit BinaryResponses(std::ostream& out);
+        ~BinaryResponses();
+
+        /* Сбрасывает буфер */
+        void Finish();
+
+        void PushBusResponse(
+            int request_id,
+            double curvature, 
+            int route_length,
+            int stop_count,
+            int unique_stop_count
+        );
+
+        void PushStopResponse(
+            int request_id,
+            const BusNamesRange& bus_names 
+        );
+
+        void PushStopSearchResponse(
+            int request_id,
+            const std::vector<FoundStop>& stops
+        );
+
+        void PushDirectResponse(
+            int request_id,
+            const BusNamesRange& buses
+        );
+
+        void PushMapResponse(
+            int request_id,
+            const std::shared_ptr<const Render::RenderedMap>& map
+        );
+
+        void PushRouteResponse(
+            int request_id,
+            double total_time,
+            json::Array items
+        );
+
+        void PushNotFoundResponse(int request_id);
+
+        void PushMemoryResponse(
+            int request_id,
+            const memory::Usage& usage
+        );
+
+    private:
+        /* Начинает тело кадра */
+        void StartFrame(ResponseKind kind, int request_id);
+        /* Пишет кадр: длину и тело */
+        void EndFrame();
+
+        template <typename T>
+        void Put(T value);
+        void PutString(std::string_view value);
+        void PutBusNames(const BusNamesRange& bus_names);
+        void PutMemoryUsage(const memory::Usage& usage);
+
+        io::BufferedOutput out_;
+        // Тело текущего кадра; память переиспользуется между ответами
+        std::string frame_;
+    };
+
+    /*
+    * Приёмник, который только считает ответы: для замера стоимости самих запросов
+    * без форматирования и вывода.
+    */
+    class NullResponses {
+    public:
+        // Карта готовится так же, как для вывода по умолчанию
+        static constexpr Render::MapFormat MAP_FORMAT = Render::MapFormat::Json;
+
+        std::size_t GetCount() const {
+            return count_;
+        }
+
+        void PushBusResponse(int, double, int, int, int) {
+            ++count_;
+        }
+
+        void PushStopResponse(int, const BusNamesRange&) {
+            ++count_;
+        }
+
+        void PushStopSearchResponse(int, const std::vector<FoundStop>&) {
+            ++count_;
+        }
+
+        void PushDirectResponse(int, const BusNamesRange&) {
+            ++count_;
+        }
+
+        void PushMapResponse(int, const std::shared_ptr<const Render::RenderedMap>&) {
+            ++count_;
+        }
+
+        void PushRouteResponse(int, double, json::Array) {
+            ++count_;
+        }
+
+        void PushNotFoundResponse(int) {
+            ++count_;
+        }
+
+        void PushMemoryResponse(int, const memory::Usage&) {
+            ++count_;
+        }
+
+    private:
+        std::size_t count_ = 0;
     };
 
 }
@@ -207,6 +531,9 @@ namespace domain {
         svg::Color GetUnderlayerColor() const;
         std::vector<svg::Color> GetPalette() const;
         double GetUnderlayerWidth() const; 
+
+        /* Все настройки карты одной структурой */
+        Render::RenderSettings ToRenderSettings() const;
     };
 }
 
@@ -227,30 +554,118 @@ namespace domain {
         std::string GetName() const;
     };
 
+    /* Вид запроса к данным; Unknown — тип, которого нет в списке: ответ "not found" */
+    enum class StatType : std::uint8_t {
+        Stop,
+        Bus,
+        StopSearch,
+        Direct,
+        Map,
+        Memory,
+        Route,
+        Unknown
+    };
+
+    StatType ParseStatType(std::string_view type);
+
+    /* Запрос к данным, разобранный из любого источника запросов */
+    struct StatRequest {
+        int id = 0;
+        StatType type = StatType::Unknown;
+        std::string name;           // Stop, Bus
+        std::string from;           // Route, Direct
+        std::string to;
+        bool direct = false;        // Route: только маршруты без пересадок
+        std::string prefix;         // StopSearch
+        std::size_t limit = 10;
+        std::size_t max_edits = 0;
+    };
+
+    StatRequest ParseStatRequest(const json::Node& node);
+
+    /*
+    * Запрос к данным, подготовленный к исполнению над снимком каталога: имена
+    * остановок и автобусов уже найдены, ненайденные помечены NOT_FOUND.
+    * Команды пакета лежат подряд и не зависят друг от друга.
+    */
+    struct StatCommand {
+        static constexpr std::uint32_t NOT_FOUND = std::numeric_limits<std::uint32_t>::max();
+
+        StatType type = StatType::Unknown;
+        bool direct = false;        // Route: только маршруты без пересадок
+        int id = 0;
+        std::uint32_t first = NOT_FOUND;    // Stop: остановка; Bus: автобус; Route, Direct: откуда
+        std::uint32_t second = NOT_FOUND;   // Route, Direct: куда
+        std::uint32_t limit = 0;            // StopSearch
+        std::uint32_t max_edits = 0;
+        std::string_view prefix;            // StopSearch: ссылка на строку исходного запроса
+    };
+
+    /* Команды для запросов requests; requests должны жить дольше команд */
+    std::vector<StatCommand> CompileStatRequests(
+        const std::vector<StatRequest>& requests,
+        const Transport::CatalogueSnapshot& snapshot
+    );
+
+    class IRequests;
+
+    /*
+    * Отвечает на запросы к данным; source — источник запросов для запроса "Memory".
+    * Приёмник ответов — параметр шаблона, поэтому вызовы Push* в цикле запросов
+    * не виртуальные и встраиваются. Цикл собран в domain.cpp для IStatResponses,
+    * JsonResponses, JsonStreamResponses, BinaryResponses и NullResponses.
+    */
+    template <typename Responses>
+    void ExecuteStatRequests(
+        const std::vector<StatRequest>& requests,
+        const IRequests& source,
+        Responses& responses,
+        const Transport::Catalogue& catalogue,
+        const Render::RoutesMap& routes_map,
+        const Transport::Router& router
+    );
+
+    /* Получатель очередной пачки запросов к данным */
+    using StatRequestsVisitor = std::function<void(const std::vector<StatRequest>&)>;
+
     /* Интерфейс класса запросов */
     class IRequests {
     public:
         virtual void FillTransportCatalogue(Transport::Catalogue& catalogue) const = 0;
         virtual void FillRenderSettings(Render::RoutesMap& routes_map) const = 0;
-        virtual RouterSettings GetRouterSettings() const = 0;
+        virtual Transport::RouterSettings GetRouterSettings() const = 0;
+        /* Запросы к данным в порядке из источника */
+        virtual std::vector<StatRequest> GetStatRequests() const = 0;
+        /* Те же запросы пачками по порядку; по умолчанию — одной пачкой из GetStatRequests */
+        virtual void VisitStatRequests(const StatRequestsVisitor& visitor) const {
+            visitor(GetStatRequests());
+        }
         virtual void FillStatResponses(
             domain::IStatResponses& responses, 
             const Transport::Catalogue& catalogue,
             const Render::RoutesMap& routes_map,
             const Transport::Router& router
         ) const = 0;
+        /* Память, занятая самими запросами */
+        virtual memory::Usage GetMemoryUsage() const = 0;
         virtual ~IRequests() = default;
     };
 
     /* Класс запросов через JSON */
     class JsonRequests : public IRequests  {
     public:
-        explicit JsonRequests(std::istream& input);
+        /* thread_count — число потоков для построения каталога и отрисовки карты */
+        explicit JsonRequests(std::istream& input, std::size_t thread_count = 1);
+        /* Запросы из непрерывного буфера, например отображённого в память файла */
+        explicit JsonRequests(std::string_view input, std::size_t thread_count = 1);
+        /* Запросы из уже разобранного документа */
+        explicit JsonRequests(json::Document document, std::size_t thread_count = 1);
 
         std::pair<std::vector<BusEntity>, std::vector<StopEntity>> GetBase() const;
         std::vector<Stat> GetStats() const;
         Settings GetRenderSettings() const;
-        RouterSettings GetRouterSettings() const;
+        Transport::RouterSettings GetRouterSettings() const override;
+        std::vector<StatRequest> GetStatRequests() const override;
 
         void FillTransportCatalogue(Transport::Catalogue& catalogue) const override;
         void FillRenderSettings(Render::RoutesMap& routes_map) const override;
@@ -260,8 +675,113 @@ namespace domain {
             const Render::RoutesMap& routes_map,
             const Transport::Router& router
         ) const override;
+        memory::Usage GetMemoryUsage() const override;
+
+        /*
+        * Пишет базу (остановки, автобусы, настройки карты и маршрутов) в двоичном
+        * формате binary_base.h для BinaryRequests. При ошибке бросает std::runtime_error.
+        */
+        void WriteBinaryBase(std::ostream& out) const;
 
     private:
         json::Document base_document_;
+        std::size_t thread_count_ = 1;
+    };
+
+    /*
+    * Класс запросов через JSON с документом в арене: разбор без множества мелких
+    * выделений памяти, документ освобождается разом. Строки документа копируются
+    * в арену, поэтому буфер input нужен только на время конструктора.
+    */
+    class ArenaJsonRequests : public IRequests {
+    public:
+        explicit ArenaJsonRequests(std::string_view input, std::size_t thread_count = 1);
+
+        Transport::RouterSettings GetRouterSettings() const override;
+        std::vector<StatRequest> GetStatRequests() const override;
+
+        void FillTransportCatalogue(Transport::Catalogue& catalogue) const override;
+        void FillRenderSettings(Render::RoutesMap& routes_map) const override;
+        void FillStatResponses(
+            domain::IStatResponses& responses, 
+            const Transport::Catalogue& catalogue,
+            const Render::RoutesMap& routes_map,
+            const Transport::Router& router
+        ) const override;
+        memory::Usage GetMemoryUsage() const override;
+
+    private:
+        json::arena::Document document_;
+        std::size_t thread_count_ = 1;
+    };
+
+    /*
+    * Класс запросов с базой в двоичном формате: каталог, карта и маршрутизатор
+    * строятся по готовым записям без разбора текста. Запросы к данным приходят
+    * отдельно. Буфер base, например отображённый в память файл, должен жить
+    * дольше объекта. Неверный буфер — std::runtime_error.
+    */
+    class BinaryRequests : public IRequests {
+    public:
+        explicit BinaryRequests(
+            std::string_view base,
+            std::vector<StatRequest> stat_requests = {},
+            std::size_t thread_count = 1
+        );
+
+        Transport::RouterSettings GetRouterSettings() const override;
+        std::vector<StatRequest> GetStatRequests() const override;
+
+        void FillTransportCatalogue(Transport::Catalogue& catalogue) const override;
+        void FillRenderSettings(Render::RoutesMap& routes_map) const override;
+        void FillStatResponses(
+            domain::IStatResponses& responses, 
+            const Transport::Catalogue& catalogue,
+            const Render::RoutesMap& routes_map,
+            const Transport::Router& router
+        ) const override;
+        memory::Usage GetMemoryUsage() const override;
+
+    private:
+        binary::BaseView base_;
+        std::vector<StatRequest> stat_requests_;
+        std::size_t thread_count_ = 1;
+    };
+
+    /*
+    * Класс запросов через JSON без построения документа целиком.
+    * Конструктор один раз проходит вход без построения узлов, переводит настройки
+    * в структуры и запоминает отрезки base_requests и stat_requests. Дальше разбирается
+    * только нужный отрезок: каталог строится по элементам base_requests, а запросы
+    * к данным отдаются исполнителю пачками по STAT_REQUESTS_BATCH, когда каталог
+    * уже готов. В памяти — один элемент и одна пачка, поэтому буфер input
+    * должен жить дольше объекта.
+    */
+    class StreamingJsonRequests : public IRequests {
+    public:
+        static constexpr std::size_t STAT_REQUESTS_BATCH = 256;
+
+        explicit StreamingJsonRequests(std::string_view input);
+
+        Transport::RouterSettings GetRouterSettings() const override;
+        std::vector<StatRequest> GetStatRequests() const override;
+        void VisitStatRequests(const StatRequestsVisitor& visitor) const override;
+
+        void FillTransportCatalogue(Transport::Catalogue& catalogue) const override;
+        void FillRenderSettings(Render::RoutesMap& routes_map) const override;
+        void FillStatResponses(
+            domain::IStatResponses& responses, 
+            const Transport::Catalogue& catalogue,
+            const Render::RoutesMap& routes_map,
+            const Transport::Router& router
+        ) const override;
+        memory::Usage GetMemoryUsage() const override;
+
+    private:
+        // Отрезки входа с массивами; пустые, если раздела нет
+        std::string_view base_requests_;
+        std::string_view stat_requests_;
+        Render::RenderSettings render_settings_;
+        Transport::RouterSettings router_settings_ = { 0, 0 };
     };
 }
@@ -5,12 +5,34 @@
 
 namespace Geo {
 
+namespace {
+
+const double dr = M_PI / 180.0;
+const double earth_radius = 6371000;
+
+} // namespace
+
 double ComputeDistance(Coordinates from, Coordinates to) {
     using namespace std;
-    const double dr = M_PI / 180.0;
     return acos(sin(from.lat * dr) * sin(to.lat * dr)
                 + cos(from.lat * dr) * cos(to.lat * dr) * cos(abs(from.lng - to.lng) * dr))
-        * 6371000;
+        * earth_radius;
+}
+
+LatitudeTrig ComputeLatitudeTrig(Coordinates point) {
+    return { std::sin(point.lat * dr), std::cos(point.lat * dr) };
+}
+
+std::vector<double> ComputeConsecutiveDistances(const std::vector<Coordinates>& points, const std::vector<LatitudeTrig>& trig) {
+    const std::size_t count = points.size() < 2 ? 0 : points.size() - 1;
+    std::vector<double> result(count);
+    /* Один проход: тригонометрия широт уже посчитана, на пару точек остаются cos и acos */
+    for (std::size_t i = 0; i < count; ++i) {
+        const double cos_lng = std::cos(std::abs(points[i].lng - points[i + 1].lng) * dr);
+        result[i] = std::acos(trig[i].sin_lat * trig[i + 1].sin_lat + trig[i].cos_lat * trig[i + 1].cos_lat * cos_lng)
+            * earth_radius;
+    }
+    return result;
 }
 
-}  // namespace geo
\ No newline at end of file
+}  // namespace geo
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cmath>
+#include <vector>
 
 namespace Geo {
 struct Coordinates {
@@ -13,5 +14,21 @@ struct Coordinates {
         return !(*this == other);
     }
 };
+
+/* Синус и косинус широты точки: не зависят от второй точки и считаются один раз */
+struct LatitudeTrig {
+    double sin_lat;
+    double cos_lat;
+};
+
 double ComputeDistance(Coordinates from, Coordinates to);
-} // end Geo
\ No newline at end of file
+
+LatitudeTrig ComputeLatitudeTrig(Coordinates point);
+
+/*
+* Расстояния между соседними точками ломаной: result[i] — от points[i] до points[i + 1].
+* trig[i] — ComputeLatitudeTrig(points[i]). Операции те же, что в ComputeDistance,
+* и выполняются в том же порядке, поэтому результат совпадает с ней бит в бит.
+*/
+std::vector<double> ComputeConsecutiveDistances(const std::vector<Coordinates>& points, const std::vector<LatitudeTrig>& trig);
+} // end Geo
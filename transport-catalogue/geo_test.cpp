@@ -0,0 +1,131 @@
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "geo.h"
+#include "json.h"
+
+/*
+* Проверка пакетного ComputeConsecutiveDistances против поточечного ComputeDistance
+* на маршрутах из тестовых баз. Каждый маршрут прогоняется всеми префиксами,
+* так что проверяются и пустые, и одноточечные ломаные.
+*/
+
+namespace {
+
+const double MAX_RELATIVE_ERROR = 1e-6;
+
+struct CheckStats {
+    std::size_t distances = 0;
+    std::size_t runs = 0;
+    std::size_t failures = 0;
+};
+
+bool IsClose(double actual, double expected) {
+    if (std::isnan(actual) || std::isnan(expected)) {
+        return false;
+    }
+    if (expected == 0) {
+        return std::abs(actual) <= MAX_RELATIVE_ERROR;
+    }
+    return std::abs(actual - expected) <= MAX_RELATIVE_ERROR * std::abs(expected);
+}
+
+void CheckRoute(const std::string& bus_name, const std::vector<Geo::Coordinates>& route, CheckStats& stats) {
+    for (std::size_t size = 0; size <= route.size(); ++size) {
+        const std::vector<Geo::Coordinates> points(route.begin(), route.begin() + size);
+        std::vector<Geo::LatitudeTrig> trig;
+        trig.reserve(size);
+        for (const Geo::Coordinates& point : points) {
+            trig.push_back(Geo::ComputeLatitudeTrig(point));
+        }
+
+        const std::vector<double> distances = Geo::ComputeConsecutiveDistances(points, trig);
+        const std::size_t expected_count = size < 2 ? 0 : size - 1;
+        if (distances.size() != expected_count) {
+            std::cerr << "Bus " << bus_name << ", " << size << " points: "
+                << distances.size() << " distances instead of " << expected_count << std::endl;
+            ++stats.failures;
+            continue;
+        }
+        ++stats.runs;
+
+        for (std::size_t i = 0; i < distances.size(); ++i) {
+            const double expected = Geo::ComputeDistance(points[i], points[i + 1]);
+            ++stats.distances;
+            if (!IsClose(distances[i], expected)) {
+                std::cerr.precision(17);
+                std::cerr << "Bus " << bus_name << ", " << size << " points, segment " << i << ": "
+                    << distances[i] << " instead of " << expected << std::endl;
+                ++stats.failures;
+            }
+        }
+    }
+}
+
+/* Прогоняет все маршруты базы; линейный маршрут проверяется туда и обратно */
+void CheckFeed(const std::string& path, CheckStats& stats) {
+    std::ifstream input(path);
+    if (!input) {
+        std::cerr << "Can't open " << path << std::endl;
+        ++stats.failures;
+        return;
+    }
+    const json::Document document = json::Load(input);
+    const json::Array& base_requests = document.GetRoot().AsDict().at("base_requests").AsArray();
+
+    std::unordered_map<std::string, Geo::Coordinates> stops;
+    for (const json::Node& request : base_requests) {
+        const json::Dict& fields = request.AsDict();
+        if (fields.at("type").AsString() == "Stop") {
+            stops[fields.at("name").AsString()] = {
+                fields.at("latitude").AsDouble(),
+                fields.at("longitude").AsDouble()
+            };
+        }
+    }
+
+    for (const json::Node& request : base_requests) {
+        const json::Dict& fields = request.AsDict();
+        if (fields.at("type").AsString() != "Bus") {
+            continue;
+        }
+        std::vector<Geo::Coordinates> route;
+        for (const json::Node& stop : fields.at("stops").AsArray()) {
+            route.push_back(stops.at(stop.AsString()));
+        }
+        if (!fields.at("is_roundtrip").AsBool() && route.size() > 1) {
+            route.insert(route.end(), route.rbegin() + 1, route.rend());
+        }
+        CheckRoute(fields.at("name").AsString(), route, stats);
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    std::vector<std::string> feeds(argv + 1, argv + argc);
+    if (feeds.empty()) {
+        for (int i = 1; i <= 3; ++i) {
+            feeds.push_back("../test_data/s12_final_opentest_" + std::to_string(i) + ".json");
+        }
+    }
+
+    CheckStats stats;
+    for (const std::string& feed : feeds) {
+        CheckFeed(feed, stats);
+    }
+
+    if (stats.distances == 0) {
+        std::cerr << "No distances are checked" << std::endl;
+        ++stats.failures;
+    }
+
+    std::cout << "geo_test: " << stats.distances << " distances in " << stats.runs << " runs, "
+        << stats.failures << " failures" << std::endl;
+    return stats.failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
@@ -35,6 +35,10 @@ public:
     const Edge<Weight>& GetEdge(EdgeId edge_id) const;
     IncidentEdgesRange GetIncidentEdges(VertexId vertex) const;
 
+    // Память под рёбра и списки инцидентности с учётом ёмкости векторов
+    std::size_t GetEdgesMemoryUsage() const;
+    std::size_t GetIncidenceMemoryUsage() const;
+
 private:
     std::vector<Edge<Weight>> edges_;
     std::vector<IncidenceList> incidence_lists_;
@@ -74,4 +78,18 @@ typename DirectedWeightedGraph<Weight>::IncidentEdgesRange
     return ranges::AsRange(incidence_lists_.at(vertex));
 }
 
+template <typename Weight>
+std::size_t DirectedWeightedGraph<Weight>::GetEdgesMemoryUsage() const {
+    return edges_.capacity() * sizeof(Edge<Weight>);
+}
+
+template <typename Weight>
+std::size_t DirectedWeightedGraph<Weight>::GetIncidenceMemoryUsage() const {
+    std::size_t bytes = incidence_lists_.capacity() * sizeof(IncidenceList);
+    for (const IncidenceList& list : incidence_lists_) {
+        bytes += list.capacity() * sizeof(EdgeId);
+    }
+    return bytes;
+}
+
 } // namespace graph
\ No newline at end of file
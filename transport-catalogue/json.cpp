@@ -1,226 +1,510 @@
 #include "json.h"
+#include "number_format.h"
 
+#include <cctype>
+#include <charconv>
+#include <cmath>
 #include <iterator>
+#include <stdexcept>
+
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
 
 namespace json {
 
 namespace {
 using namespace std::literals;
 
-Node LoadNode(std::istream& input);
-Node LoadString(std::istream& input);
+/*
+* Поиск при разборе: конец пробелов и ближайший особый символ строки
+* (кавычка, обратная косая черта, перевод строки). Векторные варианты
+* проверяют 16 или 32 байта за шаг и дочитывают хвост скалярно.
+* Пробелы те же, что у std::isspace в локали "C": ' ' и '\t'..'\r'.
+*/
+struct ScanFunctions {
+    const char* (*skip_spaces)(const char* pos, const char* end);
+    const char* (*find_string_special)(const char* pos, const char* end);
+};
+
+bool IsSpace(char c) {
+    return c == ' ' || static_cast<unsigned char>(c - '\t') <= '\r' - '\t';
+}
+
+bool IsStringSpecial(char c) {
+    return c == '"' || c == '\\' || c == '\n' || c == '\r';
+}
+
+const char* SkipSpacesScalar(const char* pos, const char* end) {
+    while (pos != end && IsSpace(*pos)) {
+        ++pos;
+    }
+    return pos;
+}
 
-std::string LoadLiteral(std::istream& input) {
-    std::string s;
-    while (std::isalpha(input.peek())) {
-        s.push_back(static_cast<char>(input.get()));
+const char* FindStringSpecialScalar(const char* pos, const char* end) {
+    while (pos != end && !IsStringSpecial(*pos)) {
+        ++pos;
     }
-    return s;
+    return pos;
 }
 
-Node LoadArray(std::istream& input) {
-    std::vector<Node> result;
+#if defined(__SSE2__)
+
+/* Маска байтов-пробелов: ' ' или (c - '\t') <= 4 без знака */
+__m128i SpaceMaskSse2(__m128i chunk) {
+    const __m128i shifted = _mm_sub_epi8(chunk, _mm_set1_epi8('\t'));
+    const __m128i control = _mm_cmpeq_epi8(_mm_min_epu8(shifted, _mm_set1_epi8('\r' - '\t')), shifted);
+    return _mm_or_si128(control, _mm_cmpeq_epi8(chunk, _mm_set1_epi8(' ')));
+}
 
-    for (char c; input >> c && c != ']';) {
-        if (c != ',') {
-            input.putback(c);
+const char* SkipSpacesSse2(const char* pos, const char* end) {
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const unsigned mask = ~static_cast<unsigned>(_mm_movemask_epi8(SpaceMaskSse2(chunk))) & 0xFFFFu;
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
         }
-        result.push_back(LoadNode(input));
     }
-    if (!input) {
-        throw ParsingError("Array parsing error"s);
+    return SkipSpacesScalar(pos, end);
+}
+
+const char* FindStringSpecialSse2(const char* pos, const char* end) {
+    for (; end - pos >= 16; pos += 16) {
+        const __m128i chunk = _mm_loadu_si128(reinterpret_cast<const __m128i*>(pos));
+        const __m128i special = _mm_or_si128(
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('"')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\\'))),
+            _mm_or_si128(_mm_cmpeq_epi8(chunk, _mm_set1_epi8('\n')), _mm_cmpeq_epi8(chunk, _mm_set1_epi8('\r')))
+        );
+        const unsigned mask = static_cast<unsigned>(_mm_movemask_epi8(special));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
     }
-    return Node(std::move(result));
+    return FindStringSpecialScalar(pos, end);
 }
 
-Node LoadDict(std::istream& input) {
-    Dict dict;
+#define JSON_HAS_SSE2_SCAN 1
+#endif
+
+#if (defined(__x86_64__) || defined(__i386__)) && defined(__GNUC__)
+
+/* AVX2 собирается для своих функций и вызывается, только если процессор его поддерживает */
+__attribute__((target("avx2"))) const char* SkipSpacesAvx2(const char* pos, const char* end) {
+    for (; end - pos >= 32; pos += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i shifted = _mm256_sub_epi8(chunk, _mm256_set1_epi8('\t'));
+        const __m256i control = _mm256_cmpeq_epi8(_mm256_min_epu8(shifted, _mm256_set1_epi8('\r' - '\t')), shifted);
+        const __m256i space = _mm256_or_si256(control, _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8(' ')));
+        const unsigned mask = ~static_cast<unsigned>(_mm256_movemask_epi8(space));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
+        }
+    }
+    return SkipSpacesScalar(pos, end);
+}
 
-    for (char c; input >> c && c != '}';) {
-        if (c == '"') {
-            std::string key = LoadString(input).AsString();
-            if (input >> c && c == ':') {
-                if (dict.find(key) != dict.end()) {
-                    throw ParsingError("Duplicate key '"s + key + "' have been found");
-                }
-                dict.emplace(std::move(key), LoadNode(input));
-            } else {
-                throw ParsingError(": is expected but '"s + c + "' has been found"s);
-            }
-        } else if (c != ',') {
-            throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+__attribute__((target("avx2"))) const char* FindStringSpecialAvx2(const char* pos, const char* end) {
+    for (; end - pos >= 32; pos += 32) {
+        const __m256i chunk = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(pos));
+        const __m256i special = _mm256_or_si256(
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('"')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\\'))),
+            _mm256_or_si256(_mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\n')), _mm256_cmpeq_epi8(chunk, _mm256_set1_epi8('\r')))
+        );
+        const unsigned mask = static_cast<unsigned>(_mm256_movemask_epi8(special));
+        if (mask != 0) {
+            return pos + __builtin_ctz(mask);
         }
     }
-    if (!input) {
-        throw ParsingError("Dictionary parsing error"s);
+    return FindStringSpecialScalar(pos, end);
+}
+
+#define JSON_HAS_AVX2_SCAN 1
+#endif
+
+bool IsKernelSupported(ScanKernel kernel) {
+    switch (kernel) {
+        case ScanKernel::Auto:
+        case ScanKernel::Scalar:
+            return true;
+        case ScanKernel::Sse2:
+#if defined(JSON_HAS_SSE2_SCAN)
+            return true;
+#else
+            return false;
+#endif
+        case ScanKernel::Avx2:
+#if defined(JSON_HAS_AVX2_SCAN)
+            return __builtin_cpu_supports("avx2");
+#else
+            return false;
+#endif
+    }
+    return false;
+}
+
+ScanFunctions GetScanFunctions(ScanKernel kernel) {
+    if (kernel == ScanKernel::Auto) {
+        // Лучший вариант определяется один раз на процесс
+        static const ScanKernel best = IsKernelSupported(ScanKernel::Avx2) ? ScanKernel::Avx2
+            : IsKernelSupported(ScanKernel::Sse2) ? ScanKernel::Sse2
+            : ScanKernel::Scalar;
+        kernel = best;
+    }
+    if (!IsKernelSupported(kernel)) {
+        throw std::invalid_argument("Scan kernel is not supported by this CPU"s);
+    }
+    switch (kernel) {
+#if defined(JSON_HAS_AVX2_SCAN)
+        case ScanKernel::Avx2:
+            return { SkipSpacesAvx2, FindStringSpecialAvx2 };
+#endif
+#if defined(JSON_HAS_SSE2_SCAN)
+        case ScanKernel::Sse2:
+            return { SkipSpacesSse2, FindStringSpecialSse2 };
+#endif
+        default:
+            return { SkipSpacesScalar, FindStringSpecialScalar };
     }
-    return Node(std::move(dict));
 }
 
-Node LoadString(std::istream& input) {
-    auto it = std::istreambuf_iterator<char>(input);
-    auto end = std::istreambuf_iterator<char>();
-    std::string s;
-    while (true) {
-        if (it == end) {
-            throw ParsingError("String parsing error");
+/* Обработчик без действий: значение только проверяется и пропускается */
+struct SkipHandler {
+    void StartDict() {}
+    void Key(std::string_view) {}
+    void EndDict() {}
+    void StartArray() {}
+    void EndArray() {}
+    void Null() {}
+    void Bool(bool) {}
+    void Int(int) {}
+    void Double(double) {}
+    void String(std::string_view) {}
+};
+
+/*
+* Разбор JSON из непрерывного буфера с передачей событий обработчику.
+* Правила те же, что были у разбора из std::istream: пробелы пропускаются
+* как у operator>>, литералы читаются по буквам, числа сначала пробуются как int.
+*/
+template <typename EventHandler>
+class BufferParser {
+public:
+    BufferParser(std::string_view input, EventHandler& handler, ScanKernel kernel = ScanKernel::Auto) :
+        pos_(input.data()),
+        end_(input.data() + input.size()),
+        handler_(handler),
+        scan_(GetScanFunctions(kernel)) {}
+
+    void LoadNode() {
+        char c;
+        if (!NextNonSpace(c)) {
+            throw ParsingError("Unexpected EOF"s);
         }
-        const char ch = *it;
-        if (ch == '"') {
-            ++it;
-            break;
-        } else if (ch == '\\') {
-            ++it;
-            if (it == end) {
-                throw ParsingError("String parsing error");
+        switch (c) {
+            case '[':
+                LoadArray();
+                break;
+            case '{':
+                LoadDict();
+                break;
+            case '"':
+                handler_.String(LoadString());
+                break;
+            case 't':
+                [[fallthrough]];
+            case 'f':
+                --pos_;
+                LoadBool();
+                break;
+            case 'n':
+                --pos_;
+                LoadNull();
+                break;
+            default:
+                --pos_;
+                LoadNumber();
+                break;
+        }
+    }
+
+    /* Члены корневого словаря без событий о нём самом: func(key, value) с текстом значения */
+    template <typename Func>
+    void LoadMembers(Func func) {
+        char c;
+        if (!NextNonSpace(c) || c != '{') {
+            throw ParsingError("Dictionary is expected"s);
+        }
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == '}') {
+                closed = true;
+                break;
             }
-            const char escaped_char = *(it);
-            switch (escaped_char) {
-                case 'n':
-                    s.push_back('\n');
-                    break;
-                case 't':
-                    s.push_back('\t');
-                    break;
-                case 'r':
-                    s.push_back('\r');
-                    break;
-                case '"':
-                    s.push_back('"');
-                    break;
-                case '\\':
-                    s.push_back('\\');
-                    break;
-                default:
-                    throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+            if (c == '"') {
+                // Значение может переписать буфер строк с экранированием
+                const std::string key(LoadString());
+                if (NextNonSpace(c) && c == ':') {
+                    const char* begin = pos_;
+                    LoadNode();
+                    func(std::string_view(key), std::string_view(begin, static_cast<std::size_t>(pos_ - begin)));
+                } else {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
             }
-        } else if (ch == '\n' || ch == '\r') {
-            throw ParsingError("Unexpected end of line"s);
-        } else {
-            s.push_back(ch);
         }
-        ++it;
+        if (!closed) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
     }
 
-    return Node(std::move(s));
-}
-
-Node LoadBool(std::istream& input) {
-    const auto s = LoadLiteral(input);
-    if (s == "true"sv) {
-        return Node{true};
-    } else if (s == "false"sv) {
-        return Node{false};
-    } else {
-        throw ParsingError("Failed to parse '"s + s + "' as bool"s);
+    /* Элементы корневого массива без событий о нём самом: func() после каждого элемента */
+    template <typename Func>
+    void LoadItems(Func func) {
+        char c;
+        if (!NextNonSpace(c) || c != '[') {
+            throw ParsingError("Array is expected"s);
+        }
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == ']') {
+                closed = true;
+                break;
+            }
+            if (c != ',') {
+                --pos_;
+            }
+            LoadNode();
+            func();
+        }
+        if (!closed) {
+            throw ParsingError("Array parsing error"s);
+        }
     }
-}
 
-Node LoadNull(std::istream& input) {
-    if (auto literal = LoadLiteral(input); literal == "null"sv) {
-        return Node{nullptr};
-    } else {
-        throw ParsingError("Failed to parse '"s + literal + "' as null"s);
+private:
+    /* Аналог input >> c: пропускает пробельные символы и читает следующий */
+    bool NextNonSpace(char& c) {
+        // Чаще всего пробелов нет или он один: поиск вызывается только для длинных отступов
+        if (pos_ != end_ && IsSpace(*pos_)) {
+            ++pos_;
+            if (pos_ != end_ && IsSpace(*pos_)) {
+                pos_ = scan_.skip_spaces(pos_, end_);
+            }
+        }
+        if (pos_ == end_) {
+            return false;
+        }
+        c = *pos_++;
+        return true;
     }
-}
 
-Node LoadNumber(std::istream& input) {
-    std::string parsed_num;
+    int Peek() const {
+        return pos_ != end_ ? static_cast<unsigned char>(*pos_) : std::char_traits<char>::eof();
+    }
 
-    // Считывает в parsed_num очередной символ из input
-    auto read_char = [&parsed_num, &input] {
-        parsed_num += static_cast<char>(input.get());
-        if (!input) {
-            throw ParsingError("Failed to read number from stream"s);
+    std::string_view LoadLiteral() {
+        const char* begin = pos_;
+        while (pos_ != end_ && std::isalpha(static_cast<unsigned char>(*pos_))) {
+            ++pos_;
         }
-    };
+        return { begin, static_cast<std::size_t>(pos_ - begin) };
+    }
 
-    // Считывает одну или более цифр в parsed_num из input
-    auto read_digits = [&input, read_char] {
-        if (!std::isdigit(input.peek())) {
-            throw ParsingError("A digit is expected"s);
+    void LoadArray() {
+        handler_.StartArray();
+        char c;
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == ']') {
+                closed = true;
+                break;
+            }
+            if (c != ',') {
+                --pos_;
+            }
+            LoadNode();
         }
-        while (std::isdigit(input.peek())) {
-            read_char();
+        if (!closed) {
+            throw ParsingError("Array parsing error"s);
         }
-    };
+        handler_.EndArray();
+    }
 
-    if (input.peek() == '-') {
-        read_char();
+    void LoadDict() {
+        handler_.StartDict();
+        char c;
+        bool closed = false;
+        while (NextNonSpace(c)) {
+            if (c == '}') {
+                closed = true;
+                break;
+            }
+            if (c == '"') {
+                const std::string_view key = LoadString();
+                if (NextNonSpace(c) && c == ':') {
+                    handler_.Key(key);
+                    LoadNode();
+                } else {
+                    throw ParsingError(": is expected but '"s + c + "' has been found"s);
+                }
+            } else if (c != ',') {
+                throw ParsingError(R"(',' is expected but ')"s + c + "' has been found"s);
+            }
+        }
+        if (!closed) {
+            throw ParsingError("Dictionary parsing error"s);
+        }
+        handler_.EndDict();
     }
-    // Парсим целую часть числа
-    if (input.peek() == '0') {
-        read_char();
-        // После 0 в JSON не могут идти другие цифры
-    } else {
-        read_digits();
+
+    /*
+    * Строка после открывающей кавычки. Строка без экранирования возвращается
+    * отрезком входного буфера, иначе — раскодированной во внутренний буфер.
+    */
+    std::string_view LoadString() {
+        const char* begin = pos_;
+        pos_ = scan_.find_string_special(pos_, end_);
+        if (pos_ != end_ && *pos_ == '"') {
+            return { begin, static_cast<std::size_t>(pos_++ - begin) };
+        }
+
+        std::string& s = unescaped_;
+        s.assign(begin, pos_);
+        while (true) {
+            if (pos_ == end_) {
+                throw ParsingError("String parsing error");
+            }
+            const char ch = *pos_;
+            if (ch == '"') {
+                ++pos_;
+                break;
+            } else if (ch == '\\') {
+                ++pos_;
+                if (pos_ == end_) {
+                    throw ParsingError("String parsing error");
+                }
+                const char escaped_char = *pos_;
+                switch (escaped_char) {
+                    case 'n':
+                        s.push_back('\n');
+                        break;
+                    case 't':
+                        s.push_back('\t');
+                        break;
+                    case 'r':
+                        s.push_back('\r');
+                        break;
+                    case '"':
+                        s.push_back('"');
+                        break;
+                    case '\\':
+                        s.push_back('\\');
+                        break;
+                    default:
+                        throw ParsingError("Unrecognized escape sequence \\"s + escaped_char);
+                }
+                ++pos_;
+            } else {
+                throw ParsingError("Unexpected end of line"s);
+            }
+            // Обычные символы до следующего особого копируются одним куском
+            const char* next = scan_.find_string_special(pos_, end_);
+            s.append(pos_, next);
+            pos_ = next;
+        }
+        return s;
     }
 
-    bool is_int = true;
-    // Парсим дробную часть числа
-    if (input.peek() == '.') {
-        read_char();
-        read_digits();
-        is_int = false;
+    void LoadBool() {
+        const std::string_view s = LoadLiteral();
+        if (s == "true"sv) {
+            handler_.Bool(true);
+        } else if (s == "false"sv) {
+            handler_.Bool(false);
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(s) + "' as bool"s);
+        }
     }
 
-    // Парсим экспоненциальную часть числа
-    if (int ch = input.peek(); ch == 'e' || ch == 'E') {
-        read_char();
-        if (ch = input.peek(); ch == '+' || ch == '-') {
-            read_char();
+    void LoadNull() {
+        if (const std::string_view literal = LoadLiteral(); literal == "null"sv) {
+            handler_.Null();
+        } else {
+            throw ParsingError("Failed to parse '"s + std::string(literal) + "' as null"s);
         }
-        read_digits();
-        is_int = false;
     }
 
-    try {
+    void LoadNumber() {
+        const char* begin = pos_;
+
+        // Считывает одну или более цифр
+        auto read_digits = [this] {
+            if (!std::isdigit(Peek())) {
+                throw ParsingError("A digit is expected"s);
+            }
+            while (std::isdigit(Peek())) {
+                ++pos_;
+            }
+        };
+
+        if (Peek() == '-') {
+            ++pos_;
+        }
+        // Парсим целую часть числа
+        if (Peek() == '0') {
+            ++pos_;
+            // После 0 в JSON не могут идти другие цифры
+        } else {
+            read_digits();
+        }
+
+        bool is_int = true;
+        // Парсим дробную часть числа
+        if (Peek() == '.') {
+            ++pos_;
+            read_digits();
+            is_int = false;
+        }
+
+        // Парсим экспоненциальную часть числа
+        if (int ch = Peek(); ch == 'e' || ch == 'E') {
+            ++pos_;
+            if (ch = Peek(); ch == '+' || ch == '-') {
+                ++pos_;
+            }
+            read_digits();
+            is_int = false;
+        }
+
         if (is_int) {
             // Сначала пробуем преобразовать строку в int
-            try {
-                return std::stoi(parsed_num);
-            } catch (...) {
-                // В случае неудачи, например, при переполнении
-                // код ниже попробует преобразовать строку в double
+            int value = 0;
+            if (const std::from_chars_result result = std::from_chars(begin, pos_, value); result.ec == std::errc()) {
+                handler_.Int(value);
+                return;
             }
+            // В случае неудачи, например, при переполнении
+            // код ниже попробует преобразовать строку в double
         }
-        return std::stod(parsed_num);
-    } catch (...) {
-        throw ParsingError("Failed to convert "s + parsed_num + " to number"s);
-    }
-}
-
-Node LoadNode(std::istream& input) {
-    char c;
-    if (!(input >> c)) {
-        throw ParsingError("Unexpected EOF"s);
-    }
-    switch (c) {
-        case '[':
-            return LoadArray(input);
-        case '{':
-            return LoadDict(input);
-        case '"':
-            return LoadString(input);
-        case 't':
-            // Атрибут [[fallthrough]] (провалиться) ничего не делает, и является
-            // подсказкой компилятору и человеку, что здесь программист явно задумывал
-            // разрешить переход к инструкции следующей ветки case, а не случайно забыл
-            // написать break, return или throw.
-            // В данном случае, встретив t или f, переходим к попытке парсинга
-            // литералов true либо false
-            [[fallthrough]];
-        case 'f':
-            input.putback(c);
-            return LoadBool(input);
-        case 'n':
-            input.putback(c);
-            return LoadNull(input);
-        default:
-            input.putback(c);
-            return LoadNumber(input);
+        double value = 0.0;
+        const std::from_chars_result result = std::from_chars(begin, pos_, value);
+        // Денормализованные числа, как и раньше у std::stod, считаются выходом за диапазон
+        if (result.ec != std::errc() || result.ptr != pos_ || std::fpclassify(value) == FP_SUBNORMAL) {
+            throw ParsingError("Failed to convert "s + std::string(begin, pos_) + " to number"s);
+        }
+        handler_.Double(value);
     }
-}
+
+    const char* pos_;
+    const char* end_;
+    EventHandler& handler_;
+    ScanFunctions scan_;
+    // Буфер для строк с экранированием
+    std::string unescaped_;
+};
 
 struct PrintContext {
     std::ostream& out;
@@ -245,30 +529,58 @@ void PrintValue(const Value& value, const PrintContext& ctx) {
     ctx.out << value;
 }
 
-void PrintString(const std::string& value, std::ostream& out) {
-    out.put('"');
-    for (const char c : value) {
-        switch (c) {
+void PrintValue(int value, const PrintContext& ctx) {
+    ctx.out << format::Int{ value };
+}
+
+void PrintValue(double value, const PrintContext& ctx) {
+    ctx.out << format::Double{ value };
+}
+
+void AppendRun(std::string_view run, std::ostream& out) {
+    out.write(run.data(), static_cast<std::streamsize>(run.size()));
+}
+
+void AppendRun(std::string_view run, std::string& out) {
+    out.append(run);
+}
+
+/* Экранирует value; обычные символы уходят в out целыми отрезками */
+template <typename Out>
+void WriteEscaped(std::string_view value, Out& out) {
+    std::size_t run_begin = 0;
+    for (std::size_t i = 0; i < value.size(); ++i) {
+        std::string_view escaped;
+        switch (value[i]) {
             case '\r':
-                out << "\\r"sv;
+                escaped = "\\r"sv;
                 break;
             case '\n':
-                out << "\\n"sv;
+                escaped = "\\n"sv;
                 break;
             case '\t':
-                out << "\\t"sv;
+                escaped = "\\t"sv;
                 break;
             case '"':
                 // Символы " и \ выводятся как \" или \\, соответственно
-                [[fallthrough]];
+                escaped = "\\\""sv;
+                break;
             case '\\':
-                out.put('\\');
-                [[fallthrough]];
-            default:
-                out.put(c);
+                escaped = "\\\\"sv;
                 break;
+            default:
+                continue;
         }
+        AppendRun(value.substr(run_begin, i - run_begin), out);
+        AppendRun(escaped, out);
+        run_begin = i + 1;
     }
+    AppendRun(value.substr(run_begin), out);
+}
+
+void PrintString(std::string_view value, std::ostream& out) {
+    out.put('"');
+    WriteEscaped(value, out);
     out.put('"');
 }
 
@@ -344,13 +656,255 @@ void PrintNode(const Node& node, const PrintContext& ctx) {
 }  // namespace
 
 Document Load(std::istream& input) {
-    return Document{LoadNode(input)};
+    const std::string buffer(std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>{});
+    return Load(buffer);
+}
+
+Document Load(std::string_view input) {
+    NodeBuilder builder;
+    BufferParser<NodeBuilder>(input, builder).LoadNode();
+    return Document{builder.Extract()};
+}
+
+void Parse(std::string_view input, Handler& handler, ScanKernel kernel) {
+    BufferParser<Handler>(input, handler, kernel).LoadNode();
+}
+
+void ForEachMember(std::string_view input, const std::function<void(std::string_view, std::string_view)>& func) {
+    SkipHandler handler;
+    BufferParser<SkipHandler>(input, handler).LoadMembers(func);
+}
+
+void ForEachItem(std::string_view input, const std::function<void(const Node&)>& func) {
+    NodeBuilder builder;
+    BufferParser<NodeBuilder>(input, builder).LoadItems([&builder, &func] {
+        func(builder.Extract());
+    });
+}
+
+bool IsScanKernelSupported(ScanKernel kernel) {
+    return IsKernelSupported(kernel);
+}
+
+/*
+* Построитель узлов из событий
+*/
+
+template <typename T>
+void NodeBuilder::Add(T&& value, bool is_container) {
+    Node* node = nullptr;
+    if (stack_.empty()) {
+        root_ = Node(std::forward<T>(value));
+        node = &root_;
+    } else if (Node::Value& host = stack_.back()->GetValue(); std::holds_alternative<Array>(host)) {
+        node = &std::get<Array>(host).emplace_back(std::forward<T>(value));
+    } else {
+        node = &std::get<Dict>(host).emplace(std::move(key_), std::forward<T>(value)).first->second;
+    }
+    if (is_container) {
+        stack_.push_back(node);
+    } else if (stack_.empty()) {
+        complete_ = true;
+    }
+}
+
+void NodeBuilder::StartDict() {
+    Add(Dict{}, true);
+}
+
+void NodeBuilder::Key(std::string_view key) {
+    key_ = std::string(key);
+    const Dict& dict = std::get<Dict>(stack_.back()->GetValue());
+    if (dict.find(key_) != dict.end()) {
+        throw ParsingError("Duplicate key '"s + key_ + "' have been found");
+    }
+}
+
+void NodeBuilder::EndDict() {
+    stack_.pop_back();
+    complete_ = stack_.empty();
+}
+
+void NodeBuilder::StartArray() {
+    Add(Array{}, true);
+}
+
+void NodeBuilder::EndArray() {
+    stack_.pop_back();
+    complete_ = stack_.empty();
+}
+
+void NodeBuilder::Null() {
+    Add(nullptr, false);
+}
+
+void NodeBuilder::Bool(bool value) {
+    Add(value, false);
+}
+
+void NodeBuilder::Int(int value) {
+    Add(value, false);
+}
+
+void NodeBuilder::Double(double value) {
+    Add(value, false);
+}
+
+void NodeBuilder::String(std::string_view value) {
+    Add(std::string(value), false);
+}
+
+bool NodeBuilder::IsComplete() const {
+    return complete_;
+}
+
+Node NodeBuilder::Extract() {
+    complete_ = false;
+    stack_.clear();
+    return std::move(root_);
+}
+
+/*
+* Запись по событиям
+*/
+
+Writer::Writer(std::ostream& out, bool compact) : out_(out), compact_(compact) {}
+
+void Writer::NextItem() {
+    if (has_items_.back()) {
+        out_ << (compact_ ? ","sv : ",\n"sv);
+    }
+    has_items_.back() = true;
+    WriteIndent();
+}
+
+void Writer::WriteIndent() {
+    if (!compact_) {
+        for (std::size_t i = 0; i < has_items_.size() * 4; ++i) {
+            out_.put(' ');
+        }
+    }
+}
+
+void Writer::BeforeValue() {
+    if (after_key_) {
+        after_key_ = false;
+    } else if (!has_items_.empty()) {
+        NextItem();
+    }
+}
+
+void Writer::StartDict() {
+    BeforeValue();
+    out_ << (compact_ ? "{"sv : "{\n"sv);
+    has_items_.push_back(false);
+}
+
+void Writer::Key(std::string_view key) {
+    NextItem();
+    PrintString(key, out_);
+    out_ << (compact_ ? ":"sv : ": "sv);
+    after_key_ = true;
+}
+
+void Writer::EndDict() {
+    has_items_.pop_back();
+    if (!compact_) {
+        out_.put('\n');
+    }
+    WriteIndent();
+    out_.put('}');
+}
+
+void Writer::StartArray() {
+    BeforeValue();
+    out_ << (compact_ ? "["sv : "[\n"sv);
+    has_items_.push_back(false);
+}
+
+void Writer::EndArray() {
+    has_items_.pop_back();
+    if (!compact_) {
+        out_.put('\n');
+    }
+    WriteIndent();
+    out_.put(']');
+}
+
+void Writer::Null() {
+    BeforeValue();
+    out_ << "null"sv;
+}
+
+void Writer::Bool(bool value) {
+    BeforeValue();
+    out_ << (value ? "true"sv : "false"sv);
+}
+
+void Writer::Int(int value) {
+    BeforeValue();
+    out_ << format::Int{ value };
+}
+
+void Writer::Double(double value) {
+    BeforeValue();
+    out_ << format::Double{ value };
+}
+
+void Writer::String(std::string_view value) {
+    BeforeValue();
+    PrintString(value, out_);
+}
+
+void Writer::Value(const Node& node) {
+    if (node.IsArray()) {
+        StartArray();
+        for (const Node& item : node.AsArray()) {
+            Value(item);
+        }
+        EndArray();
+    } else if (node.IsDict()) {
+        StartDict();
+        for (const auto& [key, value] : node.AsDict()) {
+            Key(key);
+            Value(value);
+        }
+        EndDict();
+    } else if (node.IsString()) {
+        String(node.AsString());
+    } else if (node.IsBool()) {
+        Bool(node.AsBool());
+    } else if (node.IsInt()) {
+        Int(node.AsInt());
+    } else if (node.IsPureDouble()) {
+        Double(node.AsDouble());
+    } else {
+        Null();
+    }
+}
+
+void Writer::Raw(std::string_view value) {
+    BeforeValue();
+    out_ << value;
 }
 
 void Print(const Document& doc, std::ostream& output) {
     PrintNode(doc.GetRoot(), PrintContext{output});
 }
 
+std::string Quote(std::string_view value) {
+    std::string result;
+    result.reserve(value.size() + 2);
+    result.push_back('"');
+    WriteEscaped(value, result);
+    result.push_back('"');
+    return result;
+}
+
+void AppendEscaped(std::string_view value, std::string& target) {
+    WriteEscaped(value, target);
+}
+
 void Node::SetValue(Node::Value value) {
     if (std::holds_alternative<bool>(value)) {
         *this = std::get<bool>(value);
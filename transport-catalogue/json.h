@@ -1,8 +1,10 @@
 #pragma once
 
+#include <functional>
 #include <iostream>
 #include <map>
 #include <string>
+#include <string_view>
 #include <variant>
 #include <vector>
 
@@ -143,8 +145,132 @@ inline bool operator!=(const Document& lhs, const Document& rhs) {
     return !(lhs == rhs);
 }
 
+/*
+* Обработчик событий потокового разбора. Строки и ключи передаются как string_view,
+* действительные только до возврата из обработчика.
+*/
+class Handler {
+public:
+    virtual void StartDict() = 0;
+    virtual void Key(std::string_view key) = 0;
+    virtual void EndDict() = 0;
+    virtual void StartArray() = 0;
+    virtual void EndArray() = 0;
+    virtual void Null() = 0;
+    virtual void Bool(bool value) = 0;
+    virtual void Int(int value) = 0;
+    virtual void Double(double value) = 0;
+    virtual void String(std::string_view value) = 0;
+
+    virtual ~Handler() = default;
+};
+
+/* Собирает узел из событий; события можно подавать по одному поддереву */
+class NodeBuilder final : public Handler {
+public:
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+
+    /* Корневое значение получено полностью */
+    bool IsComplete() const;
+    /* Забирает собранный узел; построитель готов к следующему */
+    Node Extract();
+
+private:
+    template <typename T>
+    void Add(T&& value, bool is_container);
+
+    Node root_;
+    std::vector<Node*> stack_;
+    std::string key_;
+    bool complete_ = false;
+};
+
+/*
+* Пишет JSON по событиям прямо в поток, не собирая узлов. Вывод с отступами
+* совпадает с Print, если ключи словаря подаются по возрастанию, как их хранит Dict.
+* Компактный вывод — без пробелов и переводов строк.
+*/
+class Writer final : public Handler {
+public:
+    explicit Writer(std::ostream& out, bool compact = false);
+
+    void StartDict() override;
+    void Key(std::string_view key) override;
+    void EndDict() override;
+    void StartArray() override;
+    void EndArray() override;
+    void Null() override;
+    void Bool(bool value) override;
+    void Int(int value) override;
+    void Double(double value) override;
+    void String(std::string_view value) override;
+
+    /* Узел целиком */
+    void Value(const Node& node);
+    /* Готовое значение JSON, записанное как есть, например строка из Quote */
+    void Raw(std::string_view value);
+
+private:
+    void BeforeValue();
+    void NextItem();
+    void WriteIndent();
+
+    std::ostream& out_;
+    bool compact_;
+    // По открытым контейнерам: записан ли уже хотя бы один элемент
+    std::vector<bool> has_items_;
+    bool after_key_ = false;
+};
+
+/* Вариант поиска пробелов и особых символов строк; Auto выбирает лучший для процессора */
+enum class ScanKernel { Auto, Scalar, Sse2, Avx2 };
+
+bool IsScanKernelSupported(ScanKernel kernel);
+
+/*
+* Разбирает буфер, передавая события обработчику вместо построения узлов.
+* Неподдерживаемый процессором kernel — std::invalid_argument.
+*/
+void Parse(std::string_view input, Handler& handler, ScanKernel kernel = ScanKernel::Auto);
+
+/*
+* Обходит корневой словарь, не строя узлов: func(key, value) получает ключ и отрезок
+* input с текстом значения. Значения при этом проверяются целиком, так что ошибка
+* разбора всплывает здесь, а не при разборе отрезка.
+*/
+void ForEachMember(std::string_view input, const std::function<void(std::string_view, std::string_view)>& func);
+
+/* Разбирает корневой массив по одному элементу: в памяти только текущий узел */
+void ForEachItem(std::string_view input, const std::function<void(const Node&)>& func);
+
+/* Читает поток целиком в буфер и разбирает его через Load(std::string_view) */
 Document Load(std::istream& input);
 
+/*
+* Разбор непрерывного буфера, например отображённого в память файла.
+* Строки без экранирования копируются в узлы целиком, без посимвольного роста.
+* Буфер нужен только на время вызова.
+*/
+Document Load(std::string_view input);
+
 void Print(const Document& doc, std::ostream& output);
 
+/* Строка литералом JSON: в кавычках и с экранированием, как её пишут Print и Writer */
+std::string Quote(std::string_view value);
+
+/*
+* Дописывает value в target с экранированием, но без кавычек. Подходит как фильтр
+* io::StringOutput: так документ пишется литералом JSON по мере вывода.
+*/
+void AppendEscaped(std::string_view value, std::string& target);
+
 }  // namespace json
\ No newline at end of file
@@ -0,0 +1,346 @@
+#include <algorithm>
+#include <cstring>
+#include <memory_resource>
+#include <stdexcept>
+#include <string>
+#include <unordered_set>
+#include <vector>
+
+#include "json_arena.h"
+
+namespace json::arena {
+
+using namespace std::literals;
+
+namespace {
+
+/* Считает байты, которые арена берёт у кучи */
+class CountingResource final : public std::pmr::memory_resource {
+public:
+    std::size_t GetBytes() const {
+        return bytes_;
+    }
+
+private:
+    void* do_allocate(std::size_t bytes, std::size_t alignment) override {
+        bytes_ += bytes;
+        return std::pmr::new_delete_resource()->allocate(bytes, alignment);
+    }
+
+    void do_deallocate(void* p, std::size_t bytes, std::size_t alignment) override {
+        std::pmr::new_delete_resource()->deallocate(p, bytes, alignment);
+    }
+
+    bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override {
+        return this == &other;
+    }
+
+    std::size_t bytes_ = 0;
+};
+
+} // namespace
+
+struct Document::Storage {
+    CountingResource upstream;
+    std::pmr::monotonic_buffer_resource arena{ &upstream };
+    Node root;
+};
+
+/*
+* Собирает документ из событий разбора. Значения незакрытых массивов и словарей
+* копятся в общих рабочих стеках и при закрытии переносятся в арену одним куском.
+*/
+class Builder final : public json::Handler {
+public:
+    explicit Builder(std::pmr::memory_resource& arena) : arena_(arena) {}
+
+    void StartDict() override {
+        frames_.push_back({ true, entries_.size(), key_ });
+    }
+
+    void Key(std::string_view key) override {
+        key_ = Intern(key);
+        // Ключи общие на документ, поэтому повтор ключа — совпадение указателей
+        for (std::size_t i = frames_.back().start; i < entries_.size(); ++i) {
+            if (entries_[i].first.data() == key_.data()) {
+                throw ParsingError("Duplicate key '"s + std::string(key) + "' have been found");
+            }
+        }
+    }
+
+    void EndDict() override {
+        const std::size_t start = frames_.back().start;
+        key_ = frames_.back().key;
+        frames_.pop_back();
+        std::sort(entries_.begin() + start, entries_.end(), [](const Entry& lhs, const Entry& rhs) {
+            return lhs.first < rhs.first;
+        });
+        Node node;
+        node.type_ = Node::Type::Dict;
+        node.size_ = static_cast<std::uint32_t>(entries_.size() - start);
+        node.entries_ = Copy(entries_.data() + start, node.size_);
+        entries_.resize(start);
+        Put(node);
+    }
+
+    void StartArray() override {
+        frames_.push_back({ false, values_.size(), key_ });
+    }
+
+    void EndArray() override {
+        const std::size_t start = frames_.back().start;
+        key_ = frames_.back().key;
+        frames_.pop_back();
+        Node node;
+        node.type_ = Node::Type::Array;
+        node.size_ = static_cast<std::uint32_t>(values_.size() - start);
+        node.items_ = Copy(values_.data() + start, node.size_);
+        values_.resize(start);
+        Put(node);
+    }
+
+    void Null() override {
+        Put(Node{});
+    }
+
+    void Bool(bool value) override {
+        Node node;
+        node.type_ = Node::Type::Bool;
+        node.bool_ = value;
+        Put(node);
+    }
+
+    void Int(int value) override {
+        Node node;
+        node.type_ = Node::Type::Int;
+        node.int_ = value;
+        Put(node);
+    }
+
+    void Double(double value) override {
+        Node node;
+        node.type_ = Node::Type::Double;
+        node.double_ = value;
+        Put(node);
+    }
+
+    void String(std::string_view value) override {
+        Node node;
+        node.type_ = Node::Type::String;
+        node.size_ = static_cast<std::uint32_t>(value.size());
+        node.string_ = Copy(value.data(), value.size());
+        Put(node);
+    }
+
+    const Node& GetRoot() const {
+        return root_;
+    }
+
+private:
+    struct Frame {
+        bool is_dict;
+        std::size_t start;
+        // Ключ, под которым контейнер ляжет в родительский словарь
+        std::string_view key;
+    };
+
+    void Put(const Node& node) {
+        if (frames_.empty()) {
+            root_ = node;
+        } else if (frames_.back().is_dict) {
+            entries_.push_back({ key_, node });
+        } else {
+            values_.push_back(node);
+        }
+    }
+
+    template <typename T>
+    const T* Copy(const T* data, std::size_t count) {
+        if (count == 0) {
+            return nullptr;
+        }
+        void* memory = arena_.allocate(count * sizeof(T), alignof(T));
+        std::memcpy(memory, data, count * sizeof(T));
+        return static_cast<const T*>(memory);
+    }
+
+    std::string_view Intern(std::string_view key) {
+        if (const auto it = keys_.find(key); it != keys_.end()) {
+            return *it;
+        }
+        const std::string_view stored(Copy(key.data(), key.size()), key.size());
+        keys_.insert(stored);
+        return stored;
+    }
+
+    std::pmr::memory_resource& arena_;
+    Node root_;
+    std::vector<Frame> frames_;
+    std::vector<Node> values_;
+    std::vector<Entry> entries_;
+    std::string_view key_;
+    std::unordered_set<std::string_view> keys_;
+};
+
+/*
+* Узел
+*/
+
+bool Node::IsNull() const {
+    return type_ == Type::Null;
+}
+
+bool Node::IsBool() const {
+    return type_ == Type::Bool;
+}
+
+bool Node::IsInt() const {
+    return type_ == Type::Int;
+}
+
+bool Node::IsPureDouble() const {
+    return type_ == Type::Double;
+}
+
+bool Node::IsDouble() const {
+    return IsInt() || IsPureDouble();
+}
+
+bool Node::IsString() const {
+    return type_ == Type::String;
+}
+
+bool Node::IsArray() const {
+    return type_ == Type::Array;
+}
+
+bool Node::IsDict() const {
+    return type_ == Type::Dict;
+}
+
+bool Node::AsBool() const {
+    if (!IsBool()) {
+        throw std::logic_error("Not a bool"s);
+    }
+    return bool_;
+}
+
+int Node::AsInt() const {
+    if (!IsInt()) {
+        throw std::logic_error("Not an int"s);
+    }
+    return int_;
+}
+
+double Node::AsDouble() const {
+    if (!IsDouble()) {
+        throw std::logic_error("Not a double"s);
+    }
+    return IsPureDouble() ? double_ : int_;
+}
+
+std::string_view Node::AsString() const {
+    if (!IsString()) {
+        throw std::logic_error("Not a string"s);
+    }
+    return { string_, size_ };
+}
+
+Array Node::AsArray() const {
+    if (!IsArray()) {
+        throw std::logic_error("Not an array"s);
+    }
+    return { items_, size_ };
+}
+
+Dict Node::AsDict() const {
+    if (!IsDict()) {
+        throw std::logic_error("Not a dict"s);
+    }
+    return { entries_, size_ };
+}
+
+json::Node Node::ToNode() const {
+    switch (type_) {
+        case Type::Null:
+            return nullptr;
+        case Type::Bool:
+            return bool_;
+        case Type::Int:
+            return int_;
+        case Type::Double:
+            return double_;
+        case Type::String:
+            return std::string(AsString());
+        case Type::Array: {
+            json::Array array;
+            array.reserve(size_);
+            for (const Node& item : AsArray()) {
+                array.push_back(item.ToNode());
+            }
+            return array;
+        }
+        case Type::Dict: {
+            json::Dict dict;
+            for (const auto& [key, value] : AsDict()) {
+                dict.emplace_hint(dict.end(), std::string(key), value.ToNode());
+            }
+            return dict;
+        }
+    }
+    return nullptr;
+}
+
+/*
+* Массив и словарь
+*/
+
+const Node& Array::at(std::size_t index) const {
+    if (index >= size_) {
+        throw std::out_of_range("json::arena::Array::at"s);
+    }
+    return begin_[index];
+}
+
+const Entry* Dict::find(std::string_view key) const {
+    const Entry* it = std::lower_bound(begin(), end(), key, [](const Entry& entry, std::string_view key) {
+        return entry.first < key;
+    });
+    return it != end() && it->first == key ? it : end();
+}
+
+std::size_t Dict::count(std::string_view key) const {
+    return find(key) != end() ? 1 : 0;
+}
+
+const Node& Dict::at(std::string_view key) const {
+    const Entry* it = find(key);
+    if (it == end()) {
+        throw std::out_of_range("json::arena::Dict::at"s);
+    }
+    return it->second;
+}
+
+/*
+* Документ
+*/
+
+Document::Document(std::string_view input) : storage_(std::make_unique<Storage>()) {
+    Builder builder(storage_->arena);
+    json::Parse(input, builder);
+    storage_->root = builder.GetRoot();
+}
+
+Document::Document(Document&&) noexcept = default;
+Document& Document::operator=(Document&&) noexcept = default;
+Document::~Document() = default;
+
+const Node& Document::GetRoot() const {
+    return storage_->root;
+}
+
+std::size_t Document::GetArenaBytes() const {
+    return storage_->upstream.GetBytes();
+}
+
+} // end json::arena
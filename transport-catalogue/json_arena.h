@@ -0,0 +1,130 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string_view>
+
+#include "json.h"
+
+/*
+* Документ JSON в арене.
+*
+* Узлы, строки и элементы словарей лежат в монотонной арене документа и
+* освобождаются разом вместе с ним, без обхода дерева. Ключи словарей
+* хранятся в одном экземпляре на документ, словарь — отсортированный по ключу
+* массив пар. Методы узлов повторяют json::Node, чтобы код вида
+* node.AsDict().at("name").AsString() работал с обоими документами.
+*/
+namespace json::arena {
+
+class Node;
+class Array;
+class Dict;
+struct Entry;
+class Builder;
+
+class Node {
+public:
+    bool IsNull() const;
+    bool IsBool() const;
+    bool IsInt() const;
+    bool IsPureDouble() const;
+    bool IsDouble() const;
+    bool IsString() const;
+    bool IsArray() const;
+    bool IsDict() const;
+
+    bool AsBool() const;
+    int AsInt() const;
+    double AsDouble() const;
+    /* Строка живёт, пока жив документ */
+    std::string_view AsString() const;
+    Array AsArray() const;
+    Dict AsDict() const;
+
+    /* Копия поддерева в обычный json::Node */
+    json::Node ToNode() const;
+
+private:
+    friend class Builder;
+
+    enum class Type : std::uint8_t { Null, Bool, Int, Double, String, Array, Dict };
+
+    Type type_ = Type::Null;
+    // Длина строки или число элементов массива и словаря
+    std::uint32_t size_ = 0;
+    union {
+        bool bool_;
+        int int_;
+        double double_;
+        const char* string_;
+        const Node* items_ = nullptr;
+        const Entry* entries_;
+    };
+};
+
+/* Элемент словаря; имена полей как у std::map::value_type */
+struct Entry {
+    std::string_view first;
+    Node second;
+};
+
+class Array {
+public:
+    Array(const Node* begin, std::size_t size) : begin_(begin), size_(size) {}
+
+    const Node* begin() const { return begin_; }
+    const Node* end() const { return begin_ + size_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    const Node& operator[](std::size_t index) const { return begin_[index]; }
+    /* Бросает std::out_of_range, как std::vector::at */
+    const Node& at(std::size_t index) const;
+
+private:
+    const Node* begin_;
+    std::size_t size_;
+};
+
+class Dict {
+public:
+    Dict(const Entry* begin, std::size_t size) : begin_(begin), size_(size) {}
+
+    const Entry* begin() const { return begin_; }
+    const Entry* end() const { return begin_ + size_; }
+    std::size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+
+    /* Двоичный поиск по ключу; end(), если ключа нет */
+    const Entry* find(std::string_view key) const;
+    std::size_t count(std::string_view key) const;
+    /* Бросает std::out_of_range, как std::map::at */
+    const Node& at(std::string_view key) const;
+
+private:
+    const Entry* begin_;
+    std::size_t size_;
+};
+
+class Document {
+public:
+    /* Разбирает input; ошибки разбора те же, что у json::Load */
+    explicit Document(std::string_view input);
+
+    Document(Document&&) noexcept;
+    Document& operator=(Document&&) noexcept;
+    ~Document();
+
+    const Node& GetRoot() const;
+
+    /* Байты, запрошенные ареной у кучи */
+    std::size_t GetArenaBytes() const;
+
+private:
+    struct Storage;
+
+    std::unique_ptr<Storage> storage_;
+};
+
+} // end json::arena
@@ -1,11 +1,21 @@
+#include <algorithm>
 #include <cassert>
+#include <chrono>
 #include <iostream>
+#include <iterator>
 #include <fstream>
+#include <memory>
 #include <string>
 #include <sstream>
+#include <string_view>
 
 #include "domain.h"
 #include "map_renderer.h"
+#include "mapped_file.h"
+#include "memory_usage.h"
+#include "parallel.h"
+#include "catalogue_snapshot.h"
+#include "columnar_export.h"
 #include "request_handler.h"
 #include "svg.h"
 #include "transport_catalogue.h"
@@ -13,13 +23,346 @@
 
 using namespace std;
 
-int main() {
-    domain::JsonRequests requests(std::cin);
-    Transport::Catalogue catalogue = RequestHandler::CreateCatalogue(&requests);
-    Render::RoutesMap routes_map = RequestHandler::CreateRoutesMap(&requests);
-    Transport::Router router = RequestHandler::CreateRouter(&requests, &catalogue);
-    domain::JsonResponses responses = RequestHandler::CreateResponses<domain::JsonResponses>(&requests, catalogue, routes_map, router);
-    responses.Print(std::cout);
+/* Куда и в каком виде пишутся ответы */
+enum class ResponseSink {
+    // Массив ответов собирается целиком и печатается в конце
+    Document,
+    // JSON пишется по мере готовности ответов
+    Json,
+    // Двоичные кадры domain::BinaryResponses
+    Binary,
+    // Ответы только считаются: замер стоимости запросов
+    Null
+};
+
+/* Параметры командной строки */
+struct ProgramOptions {
+    // --memory-report: после каждого этапа построения выводить в stderr занятую память
+    bool memory_report = false;
+    // --compact-routes: хранить последовательности остановок в снимке сжатыми
+    Transport::SnapshotOptions snapshot;
+    // --export <dir>: выгрузить каталог в двоичные колонки в каталог dir
+    std::string export_directory;
+    // --export-travel-times: добавить к выгрузке таблицу времени в пути
+    bool export_travel_times = false;
+    // --input <file>: читать запросы из файла, отображённого в память, а не из stdin
+    std::string input_file;
+    // --streaming: разбирать запросы по событиям, не строя документ целиком
+    bool streaming = false;
+    // --arena: держать документ запросов в арене
+    bool arena = false;
+    // --json-benchmark: замерить скорость разбора входа и большого синтетического документа
+    bool json_benchmark = false;
+    // --stream-responses: писать каждый ответ сразу, не собирая массив ответов
+    // --binary-responses: ответы в двоичном формате
+    // --null-responses: не выводить ответы, а в stderr сообщить время запросов
+    ResponseSink response_sink = ResponseSink::Document;
+    // --compact: ответы без отступов; включает --stream-responses
+    bool compact_responses = false;
+    // --ndjson: база — из --input или первой строкой stdin, дальше по строке
+    // на запрос к данным или на новую базу и по строке на ответ
+    bool ndjson = false;
+    // --convert-base <file>: записать базу из JSON-входа в двоичном формате и выйти
+    std::string convert_base_file;
+    // --base <file>: взять базу из двоичного файла; вход — только запросы к данным
+    std::string base_file;
+    // --threads <n>: число потоков построения каталога, выгрузки и отрисовки карты
+    std::size_t thread_count = parallel::GetDefaultThreadCount();
+};
+
+ProgramOptions ParseOptions(int argc, char* argv[]) {
+    ProgramOptions options;
+    for (int i = 1; i < argc; ++i) {
+        const std::string_view arg = argv[i];
+        if (arg == "--memory-report"sv) {
+            options.memory_report = true;
+        } else if (arg == "--compact-routes"sv) {
+            options.snapshot.compact_routes = true;
+        } else if (arg == "--export"sv) {
+            if (i + 1 == argc) {
+                throw std::invalid_argument("--export requires a directory"s);
+            }
+            options.export_directory = argv[++i];
+        } else if (arg == "--input"sv) {
+            if (i + 1 == argc) {
+                throw std::invalid_argument("--input requires a file"s);
+            }
+            options.input_file = argv[++i];
+        } else if (arg == "--streaming"sv) {
+            options.streaming = true;
+        } else if (arg == "--arena"sv) {
+            options.arena = true;
+        } else if (arg == "--json-benchmark"sv) {
+            options.json_benchmark = true;
+        } else if (arg == "--stream-responses"sv) {
+            options.response_sink = ResponseSink::Json;
+        } else if (arg == "--compact"sv) {
+            options.response_sink = ResponseSink::Json;
+            options.compact_responses = true;
+        } else if (arg == "--binary-responses"sv) {
+            options.response_sink = ResponseSink::Binary;
+        } else if (arg == "--null-responses"sv) {
+            options.response_sink = ResponseSink::Null;
+        } else if (arg == "--ndjson"sv) {
+            options.ndjson = true;
+        } else if (arg == "--convert-base"sv) {
+            if (i + 1 == argc) {
+                throw std::invalid_argument("--convert-base requires a file"s);
+            }
+            options.convert_base_file = argv[++i];
+        } else if (arg == "--base"sv) {
+            if (i + 1 == argc) {
+                throw std::invalid_argument("--base requires a file"s);
+            }
+            options.base_file = argv[++i];
+        } else if (arg == "--threads"sv) {
+            if (i + 1 == argc) {
+                throw std::invalid_argument("--threads requires a number"s);
+            }
+            const int thread_count = std::stoi(argv[++i]);
+            if (thread_count < 1) {
+                throw std::invalid_argument("--threads must be positive"s);
+            }
+            options.thread_count = static_cast<std::size_t>(thread_count);
+        } else if (arg == "--export-travel-times"sv) {
+            options.export_travel_times = true;
+        } else {
+            throw std::invalid_argument("Unknown option: "s + std::string(arg));
+        }
+    }
+    return options;
+}
+
+/* Запросы одним буфером: отображённый файл из --input или весь stdin */
+std::string_view ReadInput(const ProgramOptions& options, std::unique_ptr<io::MappedFile>& file, std::string& buffer) {
+    if (options.input_file.empty()) {
+        buffer.assign(std::istreambuf_iterator<char>(std::cin), std::istreambuf_iterator<char>());
+        return buffer;
+    }
+    file = std::make_unique<io::MappedFile>(options.input_file);
+    return file->GetContents();
+}
+
+/* Запросы к данным из JSON-документа с массивом stat_requests; остальное игнорируется */
+std::vector<domain::StatRequest> ReadStatRequests(std::string_view input) {
+    const json::Document document = json::Load(input);
+    std::vector<domain::StatRequest> stat_requests;
+    for (const json::Node& node : document.GetRoot().AsDict().at("stat_requests").AsArray()) {
+        stat_requests.push_back(domain::ParseStatRequest(node));
+    }
+    return stat_requests;
+}
+
+/* Обработчик событий, который ничего не строит: замеряется только разбор */
+class NullHandler final : public json::Handler {
+public:
+    void StartDict() override {}
+    void Key(std::string_view) override {}
+    void EndDict() override {}
+    void StartArray() override {}
+    void EndArray() override {}
+    void Null() override {}
+    void Bool(bool) override {}
+    void Int(int) override {}
+    void Double(double) override {}
+    void String(std::string_view) override {}
+};
+
+/* Скорость разбора буфера каждым поддерживаемым вариантом поиска, МБ/с */
+void BenchmarkJsonScan(std::string_view name, std::string_view input, std::ostream& out) {
+    using Clock = std::chrono::steady_clock;
+    // Повторы, пока суммарно не разобрано хотя бы столько байт
+    constexpr std::size_t MIN_TOTAL_BYTES = 256u << 20;
+    const std::pair<json::ScanKernel, std::string_view> kernels[] = {
+        { json::ScanKernel::Scalar, "scalar"sv },
+        { json::ScanKernel::Sse2, "sse2"sv },
+        { json::ScanKernel::Avx2, "avx2"sv }
+    };
+
+    out << name << ": "sv << input.size() << " bytes\n"sv;
+    const std::size_t repeats = std::max<std::size_t>(3, MIN_TOTAL_BYTES / std::max<std::size_t>(1, input.size()));
+    for (const auto& [kernel, kernel_name] : kernels) {
+        if (!json::IsScanKernelSupported(kernel)) {
+            out << "  "sv << kernel_name << ": not supported\n"sv;
+            continue;
+        }
+        NullHandler handler;
+        const Clock::time_point start = Clock::now();
+        for (std::size_t i = 0; i < repeats; ++i) {
+            json::Parse(input, handler, kernel);
+        }
+        const std::chrono::duration<double> elapsed = Clock::now() - start;
+        const double megabytes = static_cast<double>(input.size()) * repeats / (1 << 20);
+        out << "  "sv << kernel_name << ": "sv << megabytes / elapsed.count() << " MB/s\n"sv;
+    }
+}
+
+/* Вход и синтетический документ — массив копий входа размером около 64 МБ */
+void RunJsonBenchmark(std::string_view input, std::ostream& out) {
+    constexpr std::size_t SYNTHETIC_BYTES = 64u << 20;
+    BenchmarkJsonScan("input"sv, input, out);
+
+    std::string synthetic = "["s;
+    synthetic.reserve(SYNTHETIC_BYTES + input.size() + 2);
+    while (synthetic.size() < SYNTHETIC_BYTES) {
+        if (synthetic.size() > 1) {
+            synthetic += ',';
+        }
+        synthetic.append(input);
+    }
+    synthetic += ']';
+    BenchmarkJsonScan("synthetic"sv, synthetic, out);
+}
+
+void ReportMemory(const ProgramOptions& options, std::string_view phase, const memory::Usage& usage) {
+    if (options.memory_report) {
+        std::cerr << "== memory after " << phase << " ==\n";
+        memory::Print(usage, std::cerr);
+    }
+}
+
+int main(int argc, char* argv[]) {
+    ProgramOptions options;
+    try {
+        options = ParseOptions(argc, argv);
+    } catch (const std::invalid_argument& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    if (options.json_benchmark) {
+        try {
+            std::unique_ptr<io::MappedFile> file;
+            std::string buffer;
+            RunJsonBenchmark(ReadInput(options, file, buffer), std::cout);
+        } catch (const std::runtime_error& error) {
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    if (!options.convert_base_file.empty()) {
+        try {
+            std::unique_ptr<io::MappedFile> file;
+            std::string buffer;
+            const domain::JsonRequests source(ReadInput(options, file, buffer));
+            std::ofstream out(options.convert_base_file, std::ios::binary | std::ios::trunc);
+            source.WriteBinaryBase(out);
+        } catch (const std::runtime_error& error) {
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+        return 0;
+    }
+
+    // Потоковый разбор читает буфер и при построении каталога: буфер живёт до конца
+    std::unique_ptr<io::MappedFile> input_file;
+    std::string input_buffer;
+    // Двоичная база читается прямо из отображения
+    std::unique_ptr<io::MappedFile> base_file;
+    std::shared_ptr<domain::IRequests> requests_ptr;
+    try {
+        if (!options.base_file.empty()) {
+            base_file = std::make_unique<io::MappedFile>(options.base_file);
+            std::vector<domain::StatRequest> stat_requests;
+            if (!options.ndjson) {
+                std::unique_ptr<io::MappedFile> file;
+                std::string buffer;
+                stat_requests = ReadStatRequests(ReadInput(options, file, buffer));
+            }
+            requests_ptr = std::make_shared<domain::BinaryRequests>(
+                base_file->GetContents(), std::move(stat_requests), options.thread_count);
+        } else if (options.ndjson && options.input_file.empty()) {
+            // Остальной stdin — запросы к данным, поэтому база читается только первой строкой
+            std::string base_line;
+            std::getline(std::cin, base_line);
+            requests_ptr = std::make_shared<domain::JsonRequests>(std::string_view(base_line), options.thread_count);
+        } else if (options.streaming) {
+            requests_ptr = std::make_shared<domain::StreamingJsonRequests>(ReadInput(options, input_file, input_buffer));
+        } else if (options.arena) {
+            // Документ в арене копирует строки: буфер нужен только на время разбора
+            std::unique_ptr<io::MappedFile> file;
+            std::string buffer;
+            requests_ptr = std::make_shared<domain::ArenaJsonRequests>(ReadInput(options, file, buffer), options.thread_count);
+        } else if (options.input_file.empty()) {
+            requests_ptr = std::make_shared<domain::JsonRequests>(std::cin, options.thread_count);
+        } else {
+            // Отображение нужно только на время разбора
+            const io::MappedFile input(options.input_file);
+            requests_ptr = std::make_shared<domain::JsonRequests>(input.GetContents(), options.thread_count);
+        }
+    } catch (const std::runtime_error& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+    domain::IRequests& requests = *requests_ptr;
+    ReportMemory(options, "parsing"sv, requests.GetMemoryUsage());
+
+    RequestHandler::CatalogueHolder catalogue_holder(options.snapshot);
+    try {
+        catalogue_holder.Update(requests_ptr);
+    } catch (const std::exception& error) {
+        std::cerr << error.what() << std::endl;
+        return 1;
+    }
+
+    // Версия закрепляется на всё время обработки запросов
+    std::shared_ptr<const RequestHandler::CatalogueVersion> version = catalogue_holder.Pin();
+    ReportMemory(options, "catalogue"sv, version->catalogue.GetMemoryUsage());
+    if (options.snapshot.compact_routes) {
+        ReportMemory(options, "route encoding"sv, version->catalogue.GetSnapshot()->GetRouteEncodingSavings());
+    }
+    ReportMemory(options, "routes map"sv, version->routes_map.GetMemoryUsage());
+    ReportMemory(options, "router"sv, version->router.GetMemoryUsage());
+
+    if (!options.export_directory.empty()) {
+        try {
+            Transport::ExportColumns(
+                *version->catalogue.GetSnapshot(),
+                options.export_travel_times ? &version->router : nullptr,
+                options.export_directory,
+                options.thread_count
+            );
+        } catch (const std::exception& error) {
+            std::cerr << error.what() << std::endl;
+            return 1;
+        }
+    }
+
+    if (options.ndjson) {
+        RequestHandler::ServeJsonLines(std::cin, catalogue_holder, std::cout, options.thread_count);
+        return 0;
+    }
+
+    switch (options.response_sink) {
+        case ResponseSink::Document: {
+            domain::JsonResponses responses = RequestHandler::CreateResponses<domain::JsonResponses>(&requests, *version);
+            responses.Print(std::cout);
+            break;
+        }
+        case ResponseSink::Json: {
+            domain::JsonStreamResponses responses(
+                std::cout, options.compact_responses ? domain::JsonLayout::Compact : domain::JsonLayout::Indented);
+            RequestHandler::FillResponses(&requests, *version, responses);
+            responses.Finish();
+            break;
+        }
+        case ResponseSink::Binary: {
+            domain::BinaryResponses responses(std::cout);
+            RequestHandler::FillResponses(&requests, *version, responses);
+            responses.Finish();
+            break;
+        }
+        case ResponseSink::Null: {
+            domain::NullResponses responses;
+            const auto start = std::chrono::steady_clock::now();
+            RequestHandler::FillResponses(&requests, *version, responses);
+            const std::chrono::duration<double, std::milli> elapsed = std::chrono::steady_clock::now() - start;
+            std::cerr << responses.GetCount() << " responses in " << elapsed.count() << " ms" << std::endl;
+            break;
+        }
+    }
 
     return 0;
-}
\ No newline at end of file
+}
@@ -1,4 +1,9 @@
+#include <iterator>
+#include <string>
+
 #include "map_renderer.h"
+#include "output_buffer.h"
+#include "parallel.h"
 
 namespace Render {
 
@@ -60,197 +65,292 @@ svg::Point SphereProjector::operator()(Geo::Coordinates coords) const {
     };
 }
 
-void RoutesMap::AppplySettings(domain::Settings& svg_settings) {
-    /* Общие настройки */
-    render_settings_.width = svg_settings.GetWidth();
-    render_settings_.height = svg_settings.GetHeight();
-    render_settings_.padding = svg_settings.GetPadding();
-    render_settings_.stop_radius = svg_settings.GetRadius();
-    render_settings_.line_width = svg_settings.GetLineWidth();
-
-    /* Лейблы */
-    render_settings_.bus_label_font_size = svg_settings.GetBusLabelFontSize();
-    const json::Array& bus_label_offset = svg_settings.GetBusLabelOffset();
-    render_settings_.bus_label_offset = { bus_label_offset[0].AsDouble(), bus_label_offset[1].AsDouble() };
-    render_settings_.stop_label_font_size = svg_settings.GetStopLabelFontSize();
-    const json::Array& stop_label_offset = svg_settings.GetStopLabelOffset();
-    render_settings_.stop_label_offset = { stop_label_offset[0].AsDouble(), stop_label_offset[1].AsDouble() };
-
-    /* Подложка */
-    render_settings_.underlayer_color = svg_settings.GetUnderlayerColor();
-    render_settings_.color_palette = svg_settings.GetPalette();
-    render_settings_.underlayer_width = svg_settings.GetUnderlayerWidth();
+void RoutesMap::AppplySettings(const RenderSettings& settings) {
+    render_settings_ = settings;
+    std::lock_guard<std::mutex> lock(cache_->mutex);
+    for (auto& map : cache_->maps) {
+        map.reset();
+    }
+}
+
+void RoutesMap::SetThreadCount(std::size_t thread_count) {
+    thread_count_ = std::max<std::size_t>(1, thread_count);
 }
 
-std::vector<svg::Polyline> RoutesMap::GetRouteLines(const Transport::BusesDictionary& buses, const SphereProjector& sphere_projector) const {
-    std::vector<svg::Polyline> result;
-    int color_num = 0;
-    for (const auto& [ bus_name, bus ] : buses) {
-        if (bus->IsEmpty()) {
+RoutesMap::MapLayout RoutesMap::GetLayout(const Transport::CatalogueSnapshot& catalogue) const {
+    std::vector<Geo::Coordinates> route_stops_coord;
+    std::vector<Transport::BusId> buses;
+    for (Transport::BusId bus_id = 0; bus_id < catalogue.GetBusCount(); ++bus_id) {
+        const Transport::CatalogueSnapshot::StopIdRange stops = catalogue.GetBusStops(bus_id);
+        if (stops.begin() == stops.end()) {
             continue;
         }
-        std::vector<std::shared_ptr<Transport::Stop>> route_stops;
-        for(auto it = bus->route_begin(); it != bus->route_end(); ++it) {
-            route_stops.push_back(it->stop);
-        }
-        if (bus->IsLine() && bus->GetUniqueStopsSize() > 1) {
-            auto it = bus->r_route_end();
-            --it;
-            while(it != bus->r_route_begin()) {
-                route_stops.push_back(it->stop);
-                --it;
-            }
+        buses.push_back(bus_id);
+        for (Transport::StopId stop_id : stops) {
+            route_stops_coord.push_back(catalogue.GetStop(stop_id).coordinates);
         }
-        
-        svg::Polyline line;
-        for (const auto& stop : route_stops) {
-            line.AddPoint(sphere_projector(stop->GetCoordinates()));
+    }
+    std::vector<Transport::StopId> stops;
+    for (Transport::StopId stop_id = 0; stop_id < catalogue.GetStopCount(); ++stop_id) {
+        const Transport::CatalogueSnapshot::BusIdRange stop_buses = catalogue.GetStopBuses(stop_id);
+        if (stop_buses.begin() != stop_buses.end()) {
+            stops.push_back(stop_id);
         }
-        line.SetStrokeColor(render_settings_.color_palette[color_num]);
-        line.SetFillColor("none");
-        line.SetStrokeWidth(render_settings_.line_width);
-        line.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-        line.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-        
-        color_num = (color_num + 1) % render_settings_.color_palette.size();
-        
-        result.push_back(line);
     }
-    
-    return result;
+    return {
+        SphereProjector(route_stops_coord.begin(), route_stops_coord.end(), render_settings_.width, render_settings_.height, render_settings_.padding),
+        std::move(buses),
+        std::move(stops)
+    };
 }
 
-void RoutesMap::FillSVG(svg::Document& svg, const Transport::Catalogue& catalogue) const {
-    const Transport::BusesDictionary& buses = catalogue.GetAllBuses();
-    const Transport::StopsDictionary& stops = catalogue.GetAllStops();
+RoutesMap::MapStyles RoutesMap::AddStyles(svg::Document& svg) const {
+    MapStyles styles;
+    for (const svg::Color& color : render_settings_.color_palette) {
+        svg::Style line;
+        line.fill_color = "none";
+        line.stroke_color = color;
+        line.stroke_width = render_settings_.line_width;
+        line.line_cap = svg::StrokeLineCap::ROUND;
+        line.line_join = svg::StrokeLineJoin::ROUND;
+        styles.route_lines.push_back(svg.AddStyle(std::move(line)));
 
-    std::vector<Geo::Coordinates> route_stops_coord;
-    for (auto [ bus_name, bus ] : buses) {
-        for (auto it = bus->route_begin(); it != bus->route_end(); ++it) {
-            route_stops_coord.push_back(it->stop->GetCoordinates());
-        }
-    }
-    SphereProjector sp(route_stops_coord.begin(), route_stops_coord.end(), render_settings_.width, render_settings_.height, render_settings_.padding);
-    for (const auto& line : GetRouteLines(buses, sp)) {
-        svg.Add(line);
+        svg::Style label;
+        label.fill_color = color;
+        styles.bus_labels.push_back(svg.AddStyle(std::move(label)));
     }
 
-    for (const auto& label : GetBusLabel(buses, sp)) {
-        svg.Add(label);
-    }
+    /* Подложка надписей автобусов и остановок */
+    svg::Style underlayer;
+    underlayer.fill_color = render_settings_.underlayer_color;
+    underlayer.stroke_color = render_settings_.underlayer_color;
+    underlayer.stroke_width = render_settings_.underlayer_width;
+    underlayer.line_cap = svg::StrokeLineCap::ROUND;
+    underlayer.line_join = svg::StrokeLineJoin::ROUND;
+    styles.underlayer = svg.AddStyle(std::move(underlayer));
 
-    for (const auto& label : GetStopsSymbols(stops, sp)) {
-        svg.Add(label);
-    }
+    svg::Style stop_symbol;
+    stop_symbol.fill_color = "white";
+    styles.stop_symbol = svg.AddStyle(std::move(stop_symbol));
+
+    svg::Style stop_label;
+    stop_label.fill_color = "black";
+    styles.stop_label = svg.AddStyle(std::move(stop_label));
+
+    styles.font_family = svg.AddString("Verdana");
+    styles.bus_font_weight = svg.AddString("bold");
+    return styles;
+}
 
-    for (const auto& label : GetStopsLabels(stops, sp)) {
-        svg.Add(label);
+void RoutesMap::AddLayer(svg::Document& svg, MapLayer layer, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const {
+    switch (layer) {
+        case MapLayer::RouteLines:
+            AddRouteLines(svg, styles, catalogue, layout, begin, end);
+            break;
+        case MapLayer::BusLabels:
+            AddBusLabels(svg, styles, catalogue, layout, begin, end);
+            break;
+        case MapLayer::StopsSymbols:
+            AddStopsSymbols(svg, styles, catalogue, layout, begin, end);
+            break;
+        case MapLayer::StopsLabels:
+            AddStopsLabels(svg, styles, catalogue, layout, begin, end);
+            break;
     }
 }
 
-std::vector<svg::Text> RoutesMap::GetBusLabel(const Transport::BusesDictionary& buses, const SphereProjector& sp) const {
-    std::vector<svg::Text> result;
-    int color_num = 0;
-    for (const auto& [bus_number, bus] : buses) {
-        if (bus->IsEmpty()) {
-            continue;
+void RoutesMap::AddRouteLines(svg::Document& svg, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const {
+    // Вершины одного маршрута; память переиспользуется между маршрутами
+    std::vector<svg::Point> points;
+    for (std::size_t i = begin; i < end; ++i) {
+        const Transport::BusId bus_id = layout.buses[i];
+        const Transport::CatalogueSnapshot::BusRecord& bus = catalogue.GetBus(bus_id);
+        points.clear();
+        for (Transport::StopId stop_id : catalogue.GetBusStops(bus_id)) {
+            points.push_back(layout.projector(catalogue.GetStop(stop_id).coordinates));
+        }
+        svg.StartPolyline(styles.route_lines[i % styles.route_lines.size()]);
+        for (svg::Point point : points) {
+            svg.AddPolylinePoint(point);
         }
-        svg::Text text;
-        svg::Text text_underlayer;
-
-        /* Основной текст */
-        text.SetData(bus->GetName());
-        text.SetPosition(sp(bus->route_begin()->stop->GetCoordinates()));
-        text.SetOffset(render_settings_.bus_label_offset);
-        text.SetFontSize(render_settings_.bus_label_font_size);
-        text.SetFontFamily("Verdana");
-        text.SetFontWeight("bold");
-        text.SetFillColor(render_settings_.color_palette[color_num]);
-
-        color_num = (color_num + 1) % render_settings_.color_palette.size();
-        
-        /* Подложка */
-        text_underlayer.SetData(bus->GetName());
-        text_underlayer.SetFontSize(render_settings_.bus_label_font_size);
-        text_underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-        text_underlayer.SetPosition(sp(bus->route_begin()->stop->GetCoordinates()));
-        text_underlayer.SetStrokeWidth(render_settings_.underlayer_width);
-        text_underlayer.SetFontWeight("bold");
-        text_underlayer.SetOffset(render_settings_.bus_label_offset);
-        text_underlayer.SetFontFamily("Verdana");
-        text_underlayer.SetFillColor(render_settings_.underlayer_color);
-        text_underlayer.SetStrokeColor(render_settings_.underlayer_color);
-        text_underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-        
-        result.push_back(text_underlayer);
-        result.push_back(text);
-        
-        if (bus->IsLine() && bus->begin()->stop->GetName() != bus->end()->stop->GetName()) {
-            svg::Text text_second {text};
-            svg::Text text_underlayer_second {text_underlayer};
-            text_second.SetPosition(sp(bus->r_route_end()->stop->GetCoordinates()));
-            text_underlayer_second.SetPosition(sp(bus->r_route_end()->stop->GetCoordinates()));
-
-            result.push_back(text_underlayer_second);
-            result.push_back(text_second);
+        /* Некольцевой маршрут возвращается обратно по тем же остановкам */
+        if (bus.type == Transport::RouteType::Line && bus.stats.unique_stop_count > 1) {
+            for (auto it = std::next(points.rbegin()); it != points.rend(); ++it) {
+                svg.AddPolylinePoint(*it);
+            }
         }
     }
-    
-    return result;
 }
 
-std::vector<svg::Circle> RoutesMap::GetStopsSymbols(const Transport::StopsDictionary& stops, const SphereProjector& sp) const {
-    std::vector<svg::Circle> result;
-    for (const auto& [stop_name, stop] : stops) {
-        if (stop->GetBusNames().empty()) {
-            continue;
+void RoutesMap::FillSVG(svg::Document& svg, const Transport::CatalogueSnapshot& catalogue) const {
+    const MapLayout layout = GetLayout(catalogue);
+    const MapStyles styles = AddStyles(svg);
+    AddLayer(svg, MapLayer::RouteLines, styles, catalogue, layout, 0, layout.buses.size());
+    AddLayer(svg, MapLayer::BusLabels, styles, catalogue, layout, 0, layout.buses.size());
+    AddLayer(svg, MapLayer::StopsSymbols, styles, catalogue, layout, 0, layout.stops.size());
+    AddLayer(svg, MapLayer::StopsLabels, styles, catalogue, layout, 0, layout.stops.size());
+}
+
+void RoutesMap::AddBusLabels(svg::Document& svg, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const {
+    for (std::size_t i = begin; i < end; ++i) {
+        const Transport::CatalogueSnapshot::BusRecord& bus = catalogue.GetBus(layout.buses[i]);
+        const Transport::StopId first_stop = bus.first_stop;
+        const Transport::StopId last_stop = bus.last_stop;
+
+        /* Основной текст; подложка отличается только стилем */
+        svg::TextShape text;
+        text.position = layout.projector(catalogue.GetStop(first_stop).coordinates);
+        text.offset = render_settings_.bus_label_offset;
+        text.font_size = render_settings_.bus_label_font_size;
+        text.font_family = styles.font_family;
+        text.font_weight = styles.bus_font_weight;
+        text.data = svg.AddString(bus.name);
+        text.style = styles.bus_labels[i % styles.bus_labels.size()];
+        svg::TextShape text_underlayer = text;
+        text_underlayer.style = styles.underlayer;
+
+        svg.AddText(text_underlayer);
+        svg.AddText(text);
+
+        if (bus.type == Transport::RouteType::Line && first_stop != last_stop) {
+            text.position = layout.projector(catalogue.GetStop(last_stop).coordinates);
+            text_underlayer.position = text.position;
+
+            svg.AddText(text_underlayer);
+            svg.AddText(text);
         }
-        svg::Circle symbol;
-        symbol.SetCenter(sp(stop->GetCoordinates()));
-        symbol.SetRadius(render_settings_.stop_radius);
-        symbol.SetFillColor("white");
-        
-        result.push_back(symbol);
     }
-    
-    return result;
 }
 
-std::vector<svg::Text> RoutesMap::GetStopsLabels(const Transport::StopsDictionary& stops, const SphereProjector& sp) const {
-    std::vector<svg::Text> result;
-    svg::Text text;
-    svg::Text text_underlayer;
+void RoutesMap::AddStopsSymbols(svg::Document& svg, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const {
+    for (std::size_t i = begin; i < end; ++i) {
+        svg.AddCircle({ layout.projector(catalogue.GetStop(layout.stops[i]).coordinates), render_settings_.stop_radius, styles.stop_symbol });
+    }
+}
 
-    for (const auto& [stop_name, stop] : stops) {
-        if (stop->GetBusNames().empty()) {
-            continue;
+void RoutesMap::AddStopsLabels(svg::Document& svg, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const {
+    for (std::size_t i = begin; i < end; ++i) {
+        const Transport::CatalogueSnapshot::StopRecord& stop = catalogue.GetStop(layout.stops[i]);
+
+        /* Основной текст; подложка отличается только стилем */
+        svg::TextShape text;
+        text.position = layout.projector(stop.coordinates);
+        text.offset = render_settings_.stop_label_offset;
+        text.font_size = render_settings_.stop_label_font_size;
+        text.font_family = styles.font_family;
+        text.data = svg.AddString(stop.name);
+        text.style = styles.stop_label;
+        svg::TextShape text_underlayer = text;
+        text_underlayer.style = styles.underlayer;
+
+        svg.AddText(text_underlayer);
+        svg.AddText(text);
+    }
+}
+
+void RoutesMap::RenderMap(std::string& target, io::StringOutput::Filter filter, const Transport::CatalogueSnapshot& catalogue) const {
+    if (thread_count_ == 1) {
+        svg::Document document;
+        FillSVG(document, catalogue);
+        io::StringOutput out(target, filter);
+        document.Render(out);
+        return;
+    }
+
+    const MapLayout layout = GetLayout(catalogue);
+    /*
+    * Каждый слой делится на одинаковое число блоков, и поток берёт свои блоки во всех
+    * слоях сразу, чтобы дешёвые слои не оставляли потоки без работы. Блок — отдельный
+    * документ со своими стилями и строками, выведенный в свою строку через filter.
+    * Пролог документа уходит в первую часть, закрывающий тег — в последнюю.
+    */
+    const std::size_t layer_count = std::size(MAP_LAYERS);
+    const std::size_t chunk_count = parallel::GetChunkCount(std::max(layout.buses.size(), layout.stops.size()), thread_count_);
+    std::vector<std::string> parts(layer_count * chunk_count);
+    parallel::ForEachChunk(chunk_count, thread_count_, [&](std::size_t, std::size_t chunk_begin, std::size_t chunk_end) {
+        for (std::size_t chunk = chunk_begin; chunk < chunk_end; ++chunk) {
+            for (std::size_t layer_index = 0; layer_index < layer_count; ++layer_index) {
+                const MapLayer layer = MAP_LAYERS[layer_index];
+                const std::size_t count = layer == MapLayer::RouteLines || layer == MapLayer::BusLabels
+                    ? layout.buses.size()
+                    : layout.stops.size();
+                const std::size_t part_index = layer_index * chunk_count + chunk;
+
+                svg::Document fragment;
+                const MapStyles styles = AddStyles(fragment);
+                AddLayer(fragment, layer, styles, catalogue, layout, count * chunk / chunk_count, count * (chunk + 1) / chunk_count);
+
+                io::StringOutput out(parts[part_index], filter);
+                if (part_index == 0) {
+                    svg::Document::RenderBegin(out);
+                }
+                fragment.RenderShapes(out);
+                if (part_index + 1 == parts.size()) {
+                    svg::Document::RenderEnd(out);
+                }
+            }
+        }
+    });
+
+    std::size_t size = target.size();
+    for (const std::string& part : parts) {
+        size += part.size();
+    }
+    target.reserve(size);
+    for (const std::string& part : parts) {
+        target.append(part);
+    }
+}
+
+std::shared_ptr<const RenderedMap> RoutesMap::GetRenderedMap(
+    const std::shared_ptr<const Transport::CatalogueSnapshot>& catalogue,
+    MapFormat format
+) const {
+    // Замок держится на время отрисовки: одновременные запросы ждут одну карту
+    std::lock_guard<std::mutex> lock(cache_->mutex);
+    if (cache_->snapshot.lock() != catalogue) {
+        cache_->snapshot = catalogue;
+        for (auto& map : cache_->maps) {
+            map.reset();
         }
+    }
+    std::shared_ptr<const RenderedMap>& cached = cache_->maps[static_cast<int>(format)];
+    if (cached) {
+        return cached;
+    }
 
-        /* Основной текст */
-        text.SetData(stop->GetName());
-        text.SetPosition(sp(stop->GetCoordinates()));
-        text.SetOffset(render_settings_.stop_label_offset);
-        text.SetFontSize(render_settings_.stop_label_font_size);
-        text.SetFontFamily("Verdana");
-        text.SetFillColor("black");
-        
-        /* Подложка */
-        text_underlayer.SetData(stop->GetName());
-        text_underlayer.SetFontFamily("Verdana");
-        text_underlayer.SetOffset(render_settings_.stop_label_offset);
-        text_underlayer.SetPosition(sp(stop->GetCoordinates()));
-        text_underlayer.SetFontSize(render_settings_.stop_label_font_size);
-        text_underlayer.SetStrokeColor(render_settings_.underlayer_color);
-        text_underlayer.SetFillColor(render_settings_.underlayer_color);
-        text_underlayer.SetStrokeLineJoin(svg::StrokeLineJoin::ROUND);
-        text_underlayer.SetStrokeWidth(render_settings_.underlayer_width);
-        text_underlayer.SetStrokeLineCap(svg::StrokeLineCap::ROUND);
-        
-        result.push_back(text_underlayer);
-        result.push_back(text);
+    auto map = std::make_shared<RenderedMap>();
+    map->format = format;
+    if (format == MapFormat::Json) {
+        map->data.push_back('"');
+        RenderMap(map->data, json::AppendEscaped, *catalogue);
+        map->data.push_back('"');
+    } else {
+        RenderMap(map->data, nullptr, *catalogue);
+    }
+    cached = map;
+    return map;
+}
+
+memory::Usage RoutesMap::GetMemoryUsage() const {
+    std::size_t palette_bytes = memory::GetHeapBytes(render_settings_.color_palette);
+    for (const svg::Color& color : render_settings_.color_palette) {
+        if (std::holds_alternative<std::string>(color)) {
+            palette_bytes += memory::GetHeapBytes(std::get<std::string>(color));
+        }
+    }
+    std::size_t rendered_map_bytes = 0;
+    {
+        std::lock_guard<std::mutex> lock(cache_->mutex);
+        for (const auto& map : cache_->maps) {
+            if (map) {
+                rendered_map_bytes += sizeof(RenderedMap) + memory::SHARED_CONTROL_BLOCK + memory::GetHeapBytes(map->data);
+            }
+        }
     }
-    
-    return result;
+    return memory::Usage{ "routes_map", sizeof(RoutesMap) + sizeof(MapCache), {} }
+        .AddPart("color_palette", palette_bytes)
+        .AddPart("rendered_map", rendered_map_bytes);
 }
 
 } // end Render
\ No newline at end of file
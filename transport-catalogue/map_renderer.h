@@ -4,9 +4,14 @@
 #include "svg.h"
 #include "geo.h"
 #include "json.h"
+#include "memory_usage.h"
+#include "output_buffer.h"
+#include "catalogue_snapshot.h"
 #include "transport_catalogue.h"
 
 #include <algorithm>
+#include <memory>
+#include <mutex>
 
 namespace Render {
 
@@ -41,17 +46,75 @@ public:
 		requests->FillRenderSettings(*this);
 	}
 
-	void AppplySettings(domain::Settings& svg_settings);
+	void AppplySettings(const RenderSettings& settings);
+	/* Число потоков отрисовки карты; 1 — весь документ в вызывающем потоке */
+	void SetThreadCount(std::size_t thread_count);
 	
-	std::vector<svg::Polyline> GetRouteLines(const Transport::BusesDictionary& buses, const SphereProjector& sp) const;
-    std::vector<svg::Text> GetBusLabel(const Transport::BusesDictionary& buses, const SphereProjector& sp) const;
-    std::vector<svg::Text> GetStopsLabels(const Transport::StopsDictionary& stops, const SphereProjector& sp) const;
-    std::vector<svg::Circle> GetStopsSymbols(const Transport::StopsDictionary& stops, const SphereProjector& sp) const;
+	void FillSVG(svg::Document& svg, const Transport::CatalogueSnapshot& catalogue) const;
 
-	void FillSVG(svg::Document& svg, const Transport::Catalogue& catalogue) const;
+	/*
+	* Карта снимка в виде format: отрисовывается при первом вызове и переиспользуется,
+	* пока не сменятся снимок или настройки. Документ пишется сразу в строку карты,
+	* для Json — с экранированием по ходу вывода. Слои карты и блоки автобусов или
+	* остановок в них отрисовываются в отдельных потоках и сливаются в порядке слоёв,
+	* байт в байт как при отрисовке в одном потоке. Можно вызывать из нескольких потоков.
+	*/
+	std::shared_ptr<const RenderedMap> GetRenderedMap(
+		const std::shared_ptr<const Transport::CatalogueSnapshot>& catalogue,
+		MapFormat format
+	) const;
+
+	memory::Usage GetMemoryUsage() const;
 	
 private:
+	/* Стили и общие строки карты, добавленные в документ один раз */
+	struct MapStyles {
+		// По цвету палитры
+		std::vector<svg::StyleId> route_lines;
+		std::vector<svg::StyleId> bus_labels;
+		svg::StyleId underlayer;
+		svg::StyleId stop_symbol;
+		svg::StyleId stop_label;
+		svg::StringRef font_family;
+		svg::StringRef bus_font_weight;
+	};
+
+	/* Слои карты в порядке вывода */
+	enum class MapLayer { RouteLines, BusLabels, StopsSymbols, StopsLabels };
+	static constexpr MapLayer MAP_LAYERS[] = { MapLayer::RouteLines, MapLayer::BusLabels, MapLayer::StopsSymbols, MapLayer::StopsLabels };
+
+	/* Что рисуется на карте снимка: проекция, автобусы и остановки с маршрутами */
+	struct MapLayout {
+		SphereProjector projector;
+		// Номер автобуса в buses задаёт его цвет палитры
+		std::vector<Transport::BusId> buses;
+		std::vector<Transport::StopId> stops;
+	};
+
+	MapLayout GetLayout(const Transport::CatalogueSnapshot& catalogue) const;
+	MapStyles AddStyles(svg::Document& svg) const;
+
+	/* Элементы слоя для автобусов или остановок [begin, end) раскладки */
+	void AddLayer(svg::Document& svg, MapLayer layer, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const;
+	void AddRouteLines(svg::Document& svg, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const;
+	void AddBusLabels(svg::Document& svg, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const;
+	void AddStopsSymbols(svg::Document& svg, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const;
+	void AddStopsLabels(svg::Document& svg, const MapStyles& styles, const Transport::CatalogueSnapshot& catalogue, const MapLayout& layout, std::size_t begin, std::size_t end) const;
+
+	/* Дописывает документ карты в target, пропуская вывод через filter */
+	void RenderMap(std::string& target, io::StringOutput::Filter filter, const Transport::CatalogueSnapshot& catalogue) const;
+
+	struct MapCache {
+		std::mutex mutex;
+		std::weak_ptr<const Transport::CatalogueSnapshot> snapshot;
+		// По виду карты; пусто, пока этот вид не запрашивали
+		std::shared_ptr<const RenderedMap> maps[2];
+	};
+
 	RenderSettings render_settings_;
+	std::size_t thread_count_ = 1;
+	// Кэш за указателем, чтобы RoutesMap оставался перемещаемым
+	std::unique_ptr<MapCache> cache_ = std::make_unique<MapCache>();
 };
 
 } // end Render
\ No newline at end of file
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <string>
+#include <string_view>
+
+namespace io {
+
+/*
+* Файл, отображённый в память только для чтения.
+* Там, где отображение недоступно, содержимое читается в собственный буфер.
+* Содержимое действительно, пока жив объект.
+*/
+class MappedFile {
+public:
+    /* Бросает std::runtime_error, если файл не удалось открыть или отобразить */
+    explicit MappedFile(const std::string& path);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    ~MappedFile();
+
+    std::string_view GetContents() const;
+
+private:
+    const char* data_ = nullptr;
+    std::size_t size_ = 0;
+    bool mapped_ = false;
+    std::string buffer_;
+};
+
+} // end io
@@ -0,0 +1,71 @@
+#include <variant>
+
+#include "json.h"
+#include "memory_usage.h"
+
+namespace memory {
+
+std::size_t Usage::GetTotal() const {
+    std::size_t total = bytes;
+    for (const Usage& part : parts) {
+        total += part.GetTotal();
+    }
+    return total;
+}
+
+Usage& Usage::AddPart(Usage part) {
+    parts.push_back(std::move(part));
+    return *this;
+}
+
+Usage& Usage::AddPart(std::string part_name, std::size_t part_bytes) {
+    return AddPart(Usage{ std::move(part_name), part_bytes, {} });
+}
+
+namespace {
+
+void PrintUsage(const Usage& usage, std::ostream& out, int indent) {
+    for (int i = 0; i < indent; ++i) {
+        out.put(' ');
+    }
+    out << usage.name << ": " << usage.GetTotal() << " bytes\n";
+    for (const Usage& part : usage.parts) {
+        PrintUsage(part, out, indent + 2);
+    }
+}
+
+struct NodeHeapBytes {
+    std::size_t operator()(std::nullptr_t) const { return 0; }
+    std::size_t operator()(bool) const { return 0; }
+    std::size_t operator()(int) const { return 0; }
+    std::size_t operator()(double) const { return 0; }
+    std::size_t operator()(const std::string& value) const {
+        return GetHeapBytes(value);
+    }
+    std::size_t operator()(const json::Array& values) const {
+        std::size_t bytes = GetHeapBytes<json::Node>(values);
+        for (const json::Node& value : values) {
+            bytes += GetHeapBytes(value);
+        }
+        return bytes;
+    }
+    std::size_t operator()(const json::Dict& values) const {
+        std::size_t bytes = GetHeapBytes<std::string, json::Node>(values);
+        for (const auto& [key, value] : values) {
+            bytes += GetHeapBytes(key) + GetHeapBytes(value);
+        }
+        return bytes;
+    }
+};
+
+} // namespace
+
+void Print(const Usage& usage, std::ostream& out) {
+    PrintUsage(usage, out, 0);
+}
+
+std::size_t GetHeapBytes(const json::Node& node) {
+    return std::visit(NodeHeapBytes{}, node.GetValue());
+}
+
+} // end memory
@@ -0,0 +1,93 @@
+#pragma once
+
+#include <cstddef>
+#include <deque>
+#include <iostream>
+#include <map>
+#include <memory>
+#include <set>
+#include <string>
+#include <unordered_map>
+#include <unordered_set>
+#include <vector>
+
+namespace json {
+    class Node;
+}
+
+namespace memory {
+
+/*
+* Отчёт о занятой памяти: часть системы, её собственные байты и вложенные части.
+* Учитывается ёмкость контейнеров, а не только их размер.
+*/
+struct Usage {
+    std::string name;
+    std::size_t bytes = 0;
+    std::vector<Usage> parts;
+
+    /* Байты вместе со всеми вложенными частями */
+    std::size_t GetTotal() const;
+
+    Usage& AddPart(Usage part);
+    Usage& AddPart(std::string part_name, std::size_t part_bytes);
+};
+
+/* Печатает отчёт деревом с отступами */
+void Print(const Usage& usage, std::ostream& out);
+
+/*
+* Оценки для контейнеров стандартной библиотеки. Накладные расходы узлов
+* соответствуют libstdc++: красно-чёрное дерево — цвет и три указателя на узел,
+* хеш-таблица — указатель на следующий узел и сохранённый хеш.
+*/
+inline constexpr std::size_t TREE_NODE_OVERHEAD = 4 * sizeof(void*);
+inline constexpr std::size_t HASH_NODE_OVERHEAD = sizeof(void*) + sizeof(std::size_t);
+/* Управляющий блок shared_ptr, созданного через make_shared */
+inline constexpr std::size_t SHARED_CONTROL_BLOCK = 2 * sizeof(void*);
+
+/* Память строки вне объекта: ноль, пока строка помещается в SSO-буфер */
+inline std::size_t GetHeapBytes(const std::string& value) {
+    static const std::size_t sso_capacity = std::string().capacity();
+    return value.capacity() > sso_capacity ? value.capacity() + 1 : 0;
+}
+
+template <typename T>
+std::size_t GetHeapBytes(const std::vector<T>& values) {
+    return values.capacity() * sizeof(T);
+}
+
+template <typename T>
+std::size_t GetHeapBytes(const std::deque<T>& values) {
+    // Блоки по 512 байт и карта указателей на них
+    constexpr std::size_t block_bytes = 512;
+    const std::size_t per_block = sizeof(T) < block_bytes ? block_bytes / sizeof(T) : 1;
+    const std::size_t blocks = values.size() / per_block + 1;
+    return blocks * per_block * sizeof(T) + (blocks + 8) * sizeof(void*);
+}
+
+template <typename K, typename V, typename C>
+std::size_t GetHeapBytes(const std::map<K, V, C>& values) {
+    return values.size() * (sizeof(typename std::map<K, V, C>::value_type) + TREE_NODE_OVERHEAD);
+}
+
+template <typename T, typename C>
+std::size_t GetHeapBytes(const std::set<T, C>& values) {
+    return values.size() * (sizeof(T) + TREE_NODE_OVERHEAD);
+}
+
+template <typename K, typename V, typename H, typename E>
+std::size_t GetHeapBytes(const std::unordered_map<K, V, H, E>& values) {
+    return values.size() * (sizeof(typename std::unordered_map<K, V, H, E>::value_type) + HASH_NODE_OVERHEAD)
+        + values.bucket_count() * sizeof(void*);
+}
+
+template <typename T, typename H, typename E>
+std::size_t GetHeapBytes(const std::unordered_set<T, H, E>& values) {
+    return values.size() * (sizeof(T) + HASH_NODE_OVERHEAD) + values.bucket_count() * sizeof(void*);
+}
+
+/* Память JSON-узла вне его объекта: строки, массивы и словари вместе с вложенными узлами */
+std::size_t GetHeapBytes(const json::Node& node);
+
+} // end memory
@@ -0,0 +1,38 @@
+#pragma once
+
+#include <charconv>
+#include <ostream>
+
+/*
+* Вывод чисел без потоковых преобразований и локали.
+* Формат тот же, что у operator<< с настройками потока по умолчанию:
+* целые — как есть, дробные — %g с 6 значащими цифрами.
+*/
+namespace format {
+
+// Хватает на любое int и double в этих форматах
+constexpr int NUMBER_BUFFER_SIZE = 32;
+constexpr int DOUBLE_PRECISION = 6;
+
+struct Int {
+    long long value;
+};
+
+struct Double {
+    double value;
+};
+
+inline std::ostream& operator<<(std::ostream& out, Int number) {
+    char buffer[NUMBER_BUFFER_SIZE];
+    const std::to_chars_result result = std::to_chars(buffer, buffer + NUMBER_BUFFER_SIZE, number.value);
+    return out.write(buffer, result.ptr - buffer);
+}
+
+inline std::ostream& operator<<(std::ostream& out, Double number) {
+    char buffer[NUMBER_BUFFER_SIZE];
+    const std::to_chars_result result = std::to_chars(
+        buffer, buffer + NUMBER_BUFFER_SIZE, number.value, std::chars_format::general, DOUBLE_PRECISION);
+    return out.write(buffer, result.ptr - buffer);
+}
+
+} // end format
@@ -0,0 +1,125 @@
+#include <algorithm>
+
+#include "output_buffer.h"
+
+namespace io {
+
+BufferedOutput::Buffer::Buffer(std::ostream& target, std::size_t size) :
+    target_(target),
+    data_(std::max<std::size_t>(1, size)) {
+    setp(data_.data(), data_.data() + data_.size());
+}
+
+bool BufferedOutput::Buffer::Drain() {
+    const std::streamsize pending = pptr() - pbase();
+    if (pending > 0) {
+        target_.write(pbase(), pending);
+    }
+    setp(data_.data(), data_.data() + data_.size());
+    return static_cast<bool>(target_);
+}
+
+BufferedOutput::Buffer::int_type BufferedOutput::Buffer::overflow(int_type c) {
+    if (!Drain()) {
+        return traits_type::eof();
+    }
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize BufferedOutput::Buffer::xsputn(const char* data, std::streamsize count) {
+    if (count <= epptr() - pptr()) {
+        std::copy(data, data + count, pptr());
+        pbump(static_cast<int>(count));
+        return count;
+    }
+    // Не помещается: сбрасываем накопленное, крупный блок пишем напрямую
+    if (!Drain()) {
+        return 0;
+    }
+    if (count >= static_cast<std::streamsize>(data_.size())) {
+        target_.write(data, count);
+        return target_ ? count : 0;
+    }
+    std::copy(data, data + count, pptr());
+    pbump(static_cast<int>(count));
+    return count;
+}
+
+int BufferedOutput::Buffer::sync() {
+    if (!Drain()) {
+        return -1;
+    }
+    target_.flush();
+    return target_ ? 0 : -1;
+}
+
+BufferedOutput::BufferedOutput(std::ostream& target, std::size_t buffer_size) :
+    std::ostream(nullptr),
+    buffer_(target, buffer_size) {
+    rdbuf(&buffer_);
+}
+
+BufferedOutput::~BufferedOutput() {
+    buffer_.pubsync();
+}
+
+StringOutput::Buffer::Buffer(std::string& target, Filter filter) :
+    target_(target),
+    filter_(filter) {
+    setp(data_, data_ + BUFFER_SIZE);
+}
+
+void StringOutput::Buffer::Append(std::string_view data) {
+    if (filter_) {
+        filter_(data, target_);
+    } else {
+        target_.append(data);
+    }
+}
+
+void StringOutput::Buffer::Drain() {
+    Append({ pbase(), static_cast<std::size_t>(pptr() - pbase()) });
+    setp(data_, data_ + BUFFER_SIZE);
+}
+
+StringOutput::Buffer::int_type StringOutput::Buffer::overflow(int_type c) {
+    Drain();
+    if (!traits_type::eq_int_type(c, traits_type::eof())) {
+        *pptr() = traits_type::to_char_type(c);
+        pbump(1);
+    }
+    return traits_type::not_eof(c);
+}
+
+std::streamsize StringOutput::Buffer::xsputn(const char* data, std::streamsize count) {
+    if (count <= epptr() - pptr()) {
+        std::copy(data, data + count, pptr());
+        pbump(static_cast<int>(count));
+        return count;
+    }
+    // Крупный блок минует буфер
+    Drain();
+    Append({ data, static_cast<std::size_t>(count) });
+    return count;
+}
+
+int StringOutput::Buffer::sync() {
+    Drain();
+    return 0;
+}
+
+StringOutput::StringOutput(std::string& target, Filter filter) :
+    std::ostream(nullptr),
+    buffer_(target, filter) {
+    rdbuf(&buffer_);
+}
+
+StringOutput::~StringOutput() {
+    buffer_.pubsync();
+}
+
+} // end io
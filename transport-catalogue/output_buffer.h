@@ -0,0 +1,89 @@
+#pragma once
+
+#include <cstddef>
+#include <ostream>
+#include <streambuf>
+#include <string>
+#include <string_view>
+#include <vector>
+
+namespace io {
+
+/*
+* Поток с большим собственным буфером поверх другого потока: мелкие записи
+* копятся в памяти и уходят в target крупными блоками. Память не растёт с объёмом
+* вывода. Буфер сбрасывается при flush() и в деструкторе.
+*/
+class BufferedOutput : public std::ostream {
+public:
+    static constexpr std::size_t DEFAULT_BUFFER_SIZE = 1 << 20;
+
+    explicit BufferedOutput(std::ostream& target, std::size_t buffer_size = DEFAULT_BUFFER_SIZE);
+
+    BufferedOutput(const BufferedOutput&) = delete;
+    BufferedOutput& operator=(const BufferedOutput&) = delete;
+
+    ~BufferedOutput() override;
+
+private:
+    class Buffer : public std::streambuf {
+    public:
+        Buffer(std::ostream& target, std::size_t size);
+
+    protected:
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(const char* data, std::streamsize count) override;
+        int sync() override;
+
+    private:
+        bool Drain();
+
+        std::ostream& target_;
+        std::vector<char> data_;
+    };
+
+    Buffer buffer_;
+};
+
+/*
+* Поток, дописывающий вывод в конец строки target, без промежуточных копий.
+* Мелкие записи копятся в небольшом буфере; при сбросе блок проходит через filter,
+* если он задан, например экранирование JSON. Буфер сбрасывается при flush()
+* и в деструкторе.
+*/
+class StringOutput : public std::ostream {
+public:
+    using Filter = void (*)(std::string_view data, std::string& target);
+
+    explicit StringOutput(std::string& target, Filter filter = nullptr);
+
+    StringOutput(const StringOutput&) = delete;
+    StringOutput& operator=(const StringOutput&) = delete;
+
+    ~StringOutput() override;
+
+private:
+    class Buffer : public std::streambuf {
+    public:
+        Buffer(std::string& target, Filter filter);
+
+    protected:
+        int_type overflow(int_type c) override;
+        std::streamsize xsputn(const char* data, std::streamsize count) override;
+        int sync() override;
+
+    private:
+        void Drain();
+        void Append(std::string_view data);
+
+        static constexpr std::size_t BUFFER_SIZE = 4096;
+
+        std::string& target_;
+        Filter filter_;
+        char data_[BUFFER_SIZE];
+    };
+
+    Buffer buffer_;
+};
+
+} // end io
@@ -0,0 +1,62 @@
+#pragma once
+
+#include <algorithm>
+#include <cstddef>
+#include <exception>
+#include <thread>
+#include <vector>
+
+namespace parallel {
+
+/* Число потоков по умолчанию — по числу аппаратных потоков */
+inline std::size_t GetDefaultThreadCount() {
+    return std::max<std::size_t>(1, std::thread::hardware_concurrency());
+}
+
+/* Число блоков, на которое ForEachChunk разобьёт диапазон */
+inline std::size_t GetChunkCount(std::size_t count, std::size_t thread_count) {
+    return std::max<std::size_t>(1, std::min(thread_count, count));
+}
+
+/*
+* Делит диапазон [0, count) на непрерывные блоки по числу потоков и вызывает
+* func(chunk_index, begin, end) для каждого блока в отдельном потоке.
+* Блоки идут по возрастанию индекса, поэтому результаты, разложенные по chunk_index,
+* сливаются в исходном порядке. Исключение из любого потока пробрасывается вызывающему.
+*/
+template <typename Func>
+void ForEachChunk(std::size_t count, std::size_t thread_count, Func func) {
+    const std::size_t chunk_count = GetChunkCount(count, thread_count);
+    if (chunk_count == 1) {
+        func(std::size_t{ 0 }, std::size_t{ 0 }, count);
+        return;
+    }
+
+    std::vector<std::exception_ptr> errors(chunk_count);
+    std::vector<std::thread> threads;
+    threads.reserve(chunk_count - 1);
+    auto run_chunk = [&](std::size_t chunk) {
+        const std::size_t begin = count * chunk / chunk_count;
+        const std::size_t end = count * (chunk + 1) / chunk_count;
+        try {
+            func(chunk, begin, end);
+        } catch (...) {
+            errors[chunk] = std::current_exception();
+        }
+    };
+    for (std::size_t chunk = 1; chunk < chunk_count; ++chunk) {
+        threads.emplace_back(run_chunk, chunk);
+    }
+    // Первый блок обрабатывается в вызывающем потоке
+    run_chunk(0);
+    for (std::thread& thread : threads) {
+        thread.join();
+    }
+    for (const std::exception_ptr& error : errors) {
+        if (error) {
+            std::rethrow_exception(error);
+        }
+    }
+}
+
+} // end parallel
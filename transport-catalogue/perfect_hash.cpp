@@ -0,0 +1,127 @@
+#include <algorithm>
+#include <numeric>
+#include <stdexcept>
+
+#include "perfect_hash.h"
+
+namespace Transport {
+
+namespace {
+
+/* Финальное перемешивание splitmix64 */
+std::uint64_t Mix(std::uint64_t value) {
+    value ^= value >> 30;
+    value *= 0xbf58476d1ce4e5b9ULL;
+    value ^= value >> 27;
+    value *= 0x94d049bb133111ebULL;
+    value ^= value >> 31;
+    return value;
+}
+
+// Среднее число ключей в корзине: больше — меньше таблица, но дольше построение
+constexpr std::size_t KEYS_PER_BUCKET = 4;
+// Число попыток с разной солью, прежде чем признать набор ключей некорректным
+constexpr int MAX_SALT_ATTEMPTS = 16;
+// Предел перебора смещений одной корзины в пересчёте на число ключей
+constexpr std::size_t DISPLACEMENT_TRIES_PER_KEY = 64;
+
+} // namespace
+
+PerfectHash::PerfectHash(const std::vector<std::string_view>& keys) {
+    if (keys.empty()) {
+        return;
+    }
+    for (int attempt = 0; attempt < MAX_SALT_ATTEMPTS; ++attempt) {
+        salt_ = Mix(static_cast<std::uint64_t>(attempt) + 1);
+        if (TryBuild(keys)) {
+            return;
+        }
+    }
+    throw std::logic_error("Failed to build perfect hash: duplicate keys?");
+}
+
+std::uint64_t PerfectHash::Hash(std::string_view key, std::uint64_t salt) {
+    // FNV-1a с солью в качестве начального значения
+    std::uint64_t hash = 0xcbf29ce484222325ULL ^ salt;
+    for (const char c : key) {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3ULL;
+    }
+    return Mix(hash);
+}
+
+std::size_t PerfectHash::GetBucket(std::uint64_t hash) const {
+    return static_cast<std::size_t>(hash % displacements_.size());
+}
+
+std::size_t PerfectHash::GetSlot(std::uint64_t hash, std::uint32_t displacement) const {
+    return static_cast<std::size_t>(Mix(hash ^ (displacement * 0x9e3779b97f4a7c15ULL)) % size_);
+}
+
+bool PerfectHash::TryBuild(const std::vector<std::string_view>& keys) {
+    size_ = keys.size();
+    const std::size_t bucket_count = (size_ + KEYS_PER_BUCKET - 1) / KEYS_PER_BUCKET;
+    displacements_.assign(bucket_count, 0);
+
+    std::vector<std::vector<std::uint64_t>> buckets(bucket_count);
+    for (std::string_view key : keys) {
+        const std::uint64_t hash = Hash(key, salt_);
+        buckets[GetBucket(hash)].push_back(hash);
+    }
+
+    /* Большие корзины размещаются первыми, пока свободных слотов много */
+    std::vector<std::size_t> order(bucket_count);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&buckets](std::size_t lhs, std::size_t rhs) {
+        return buckets[lhs].size() > buckets[rhs].size();
+    });
+
+    std::vector<bool> taken(size_, false);
+    std::vector<std::size_t> slots;
+    const std::size_t max_tries = DISPLACEMENT_TRIES_PER_KEY * size_ + 1024;
+    for (std::size_t bucket : order) {
+        const std::vector<std::uint64_t>& hashes = buckets[bucket];
+        if (hashes.empty()) {
+            break;
+        }
+        bool placed = false;
+        for (std::uint32_t displacement = 0; displacement < max_tries && !placed; ++displacement) {
+            slots.clear();
+            placed = true;
+            for (std::uint64_t hash : hashes) {
+                const std::size_t slot = GetSlot(hash, displacement);
+                if (taken[slot] || std::find(slots.begin(), slots.end(), slot) != slots.end()) {
+                    placed = false;
+                    break;
+                }
+                slots.push_back(slot);
+            }
+            if (placed) {
+                displacements_[bucket] = displacement;
+                for (std::size_t slot : slots) {
+                    taken[slot] = true;
+                }
+            }
+        }
+        if (!placed) {
+            // Совпавшие хеши двух ключей: пробуем другую соль
+            return false;
+        }
+    }
+    return true;
+}
+
+std::size_t PerfectHash::operator()(std::string_view key) const {
+    const std::uint64_t hash = Hash(key, salt_);
+    return GetSlot(hash, displacements_[GetBucket(hash)]);
+}
+
+std::size_t PerfectHash::GetSize() const {
+    return size_;
+}
+
+std::size_t PerfectHash::GetMemoryUsage() const {
+    return displacements_.capacity() * sizeof(std::uint32_t);
+}
+
+} // end Transport
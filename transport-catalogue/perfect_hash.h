@@ -0,0 +1,40 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Transport {
+
+/*
+* Минимальная совершенная хеш-функция над набором уникальных строк (схема "hash and displace").
+* Ключи раскладываются по корзинам, для каждой корзины подбирается смещение,
+* при котором её ключи попадают в свободные слоты [0, n) без коллизий.
+* Поиск — одно чтение смещения корзины. Для строки вне набора возвращается
+* произвольный слот, поэтому вызывающий обязан сверить ключ в слоте.
+*/
+class PerfectHash {
+public:
+    PerfectHash() = default;
+    explicit PerfectHash(const std::vector<std::string_view>& keys);
+
+    /* Слот ключа в диапазоне [0, GetSize()); для пустого набора не вызывается */
+    std::size_t operator()(std::string_view key) const;
+
+    std::size_t GetSize() const;
+    std::size_t GetMemoryUsage() const;
+
+private:
+    static std::uint64_t Hash(std::string_view key, std::uint64_t salt);
+    std::size_t GetBucket(std::uint64_t hash) const;
+    std::size_t GetSlot(std::uint64_t hash, std::uint32_t displacement) const;
+
+    bool TryBuild(const std::vector<std::string_view>& keys);
+
+    std::uint64_t salt_ = 0;
+    std::size_t size_ = 0;
+    std::vector<std::uint32_t> displacements_;
+};
+
+} // end Transport
@@ -2,6 +2,8 @@
 #include <cassert>
 #include <iterator>
 #include <sstream>
+#include <stdexcept>
+#include <string>
 
 #include "domain.h"
 #include "geo.h"
@@ -12,8 +14,10 @@
 
 namespace RequestHandler {
 
-    Transport::Catalogue CreateCatalogue(domain::IRequests* requests_ptr) {
-        return { requests_ptr };
+    Transport::Catalogue CreateCatalogue(domain::IRequests* requests_ptr, const Transport::SnapshotOptions& options) {
+        Transport::Catalogue catalogue{ requests_ptr };
+        catalogue.Finalize(options);
+        return catalogue;
     }
 
     Render::RoutesMap CreateRoutesMap(domain::IRequests* requests_ptr) {
@@ -21,7 +25,7 @@ namespace RequestHandler {
     }
 
     Transport::Router CreateRouter(domain::IRequests* requests_ptr, Transport::Catalogue* catalogue) {
-        domain::RouterSettings settings = requests_ptr->GetRouterSettings();
+        Transport::RouterSettings settings = requests_ptr->GetRouterSettings();
         Transport::Router router = Transport::RouterCreator()
             .SetCatalogue(catalogue)
             .SetSettings(settings)
@@ -29,4 +33,141 @@ namespace RequestHandler {
         return router;
     }
 
+    /*
+    * Версия каталога
+    */
+    CatalogueVersion::CatalogueVersion(std::shared_ptr<domain::IRequests> requests, std::uint64_t version_number, const Transport::SnapshotOptions& options) :
+        number(version_number),
+        source(std::move(requests)),
+        catalogue(CreateCatalogue(source.get(), options)),
+        routes_map(source.get()),
+        // Маршрутизатор строится на месте: граф маршрутов ссылается на его поля
+        router(source->GetRouterSettings(), catalogue) {}
+
+    /*
+    * Хранилище версий
+    */
+    std::shared_ptr<const CatalogueVersion> CatalogueHolder::Pin() const {
+        return std::atomic_load(&current_);
+    }
+
+    std::shared_ptr<const CatalogueVersion> CatalogueHolder::Update(std::shared_ptr<domain::IRequests> requests) {
+        std::shared_ptr<const CatalogueVersion> version = Build(std::move(requests));
+        Publish(version);
+        return version;
+    }
+
+    std::shared_ptr<const CatalogueVersion> CatalogueHolder::Build(std::shared_ptr<domain::IRequests> requests) {
+        const std::uint64_t version_number = next_version_number_.fetch_add(1);
+        return std::make_shared<const CatalogueVersion>(std::move(requests), version_number, options_);
+    }
+
+    void CatalogueHolder::Publish(std::shared_ptr<const CatalogueVersion> version) {
+        std::lock_guard<std::mutex> lock(writers_mutex_);
+        std::shared_ptr<const CatalogueVersion> current = std::atomic_load(&current_);
+        // Версия, собранная позже уже опубликованной, не должна её откатывать
+        if (current && version && current->number > version->number) {
+            return;
+        }
+        std::atomic_store(&current_, std::move(version));
+    }
+
+    /*
+    * Сервер строк NDJSON
+    */
+    JsonLinesServer::JsonLinesServer(CatalogueHolder& holder, std::ostream& output, std::size_t thread_count) :
+        holder_(holder),
+        thread_count_(thread_count),
+        requests_(1),
+        responses_(output, domain::JsonLayout::Lines) {}
+
+    JsonLinesServer::~JsonLinesServer() {
+        Finish();
+    }
+
+    void JsonLinesServer::ServeLine(std::string_view line) {
+        if (line.find_first_not_of(" \t\r") == std::string_view::npos) {
+            return;
+        }
+        try {
+            json::Document document = json::Load(line);
+            const json::Node& root = document.GetRoot();
+            if (root.IsDict() && root.AsDict().count("base_requests") != 0) {
+                QueueBase(std::move(document));
+                return;
+            }
+            requests_.front() = domain::ParseStatRequest(root);
+        } catch (const std::exception& error) {
+            std::lock_guard<std::mutex> lock(output_mutex_);
+            responses_.PushErrorResponse(error.what());
+            return;
+        }
+        // Версия закрепляется под блокировкой вывода: ответ не обгонит строку о публикации
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        const std::shared_ptr<const CatalogueVersion> version = holder_.Pin();
+        domain::ExecuteStatRequests(requests_, *version->source, responses_, version->catalogue, version->routes_map, version->router);
+    }
+
+    void JsonLinesServer::Finish() {
+        {
+            std::lock_guard<std::mutex> lock(bases_mutex_);
+            finishing_ = true;
+        }
+        bases_ready_.notify_one();
+        if (writer_.joinable()) {
+            writer_.join();
+        }
+        std::lock_guard<std::mutex> lock(output_mutex_);
+        responses_.Finish();
+    }
+
+    void JsonLinesServer::QueueBase(json::Document base) {
+        {
+            std::lock_guard<std::mutex> lock(bases_mutex_);
+            pending_bases_.push_back(std::move(base));
+        }
+        if (!writer_.joinable()) {
+            writer_ = std::thread([this] { RunWriter(); });
+        }
+        bases_ready_.notify_one();
+    }
+
+    void JsonLinesServer::RunWriter() {
+        while (true) {
+            std::unique_lock<std::mutex> bases_lock(bases_mutex_);
+            bases_ready_.wait(bases_lock, [this] { return finishing_ || !pending_bases_.empty(); });
+            if (pending_bases_.empty()) {
+                return;
+            }
+            auto requests = std::make_shared<domain::JsonRequests>(std::move(pending_bases_.front()), thread_count_);
+            pending_bases_.pop_front();
+            bases_lock.unlock();
+
+            try {
+                // Долгая часть — без блокировок: запросы идут по прежней версии
+                std::shared_ptr<const CatalogueVersion> version = holder_.Build(std::move(requests));
+                std::lock_guard<std::mutex> lock(output_mutex_);
+                holder_.Publish(version);
+                responses_.PushBaseVersionResponse(version->number);
+            } catch (const std::exception& error) {
+                std::lock_guard<std::mutex> lock(output_mutex_);
+                responses_.PushErrorResponse(error.what());
+            }
+        }
+    }
+
+    void ServeJsonLines(
+        std::istream& input,
+        CatalogueHolder& holder,
+        std::ostream& output,
+        std::size_t thread_count
+    ) {
+        JsonLinesServer server(holder, output, thread_count);
+        std::string line;
+        while (std::getline(input, line)) {
+            server.ServeLine(line);
+        }
+        server.Finish();
+    }
+
 } // end RequestHandler 
\ No newline at end of file
@@ -1,36 +1,177 @@
 #pragma once
 
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
+#include <memory>
+#include <mutex>
 #include <string>
 #include <string_view>
+#include <thread>
 #include <vector>
 
 #include "geo.h"
 #include "domain.h"
 #include "json.h"
 #include "svg.h"
+#include "catalogue_snapshot.h"
 #include "transport_catalogue.h"
 #include "transport_router.h"
 #include "map_renderer.h"
 
 namespace RequestHandler {
 
-    Transport::Catalogue CreateCatalogue(domain::IRequests* requests_ptr);
+    Transport::Catalogue CreateCatalogue(domain::IRequests* requests_ptr, const Transport::SnapshotOptions& options = {});
     
     Render::RoutesMap CreateRoutesMap(domain::IRequests* requests_ptr);
 
+    /* 
+    * T — приёмник ответов из перечисленных у domain::ExecuteStatRequests.
+    * Ответы добавляются без виртуальных вызовов.
+    */
     template<typename T>
     T CreateResponses(
         const domain::IRequests* request_ptr, 
-        Transport::Catalogue catalogue, 
-        Render::RoutesMap routes_map,
+        const Transport::Catalogue& catalogue, 
+        const Render::RoutesMap& routes_map,
         const Transport::Router& router
     ) {
-        static_assert(std::is_base_of<domain::IStatResponses, T>::value, "T must inherit from IStatResponses");
         T stat_responses;
-        request_ptr->FillStatResponses(stat_responses, catalogue, routes_map, router);
+        request_ptr->VisitStatRequests([&](const std::vector<domain::StatRequest>& requests) {
+            domain::ExecuteStatRequests(requests, *request_ptr, stat_responses, catalogue, routes_map, router);
+        });
         return stat_responses;
     };
 
     Transport::Router CreateRouter(domain::IRequests* requests_ptr, Transport::Catalogue* catalogue);
 
+    /* 
+    * Версия данных: каталог и построенные по нему карта и маршрутизатор.
+    * После создания не меняется, поэтому читается из любых потоков без блокировок.
+    */
+    struct CatalogueVersion {
+        CatalogueVersion(std::shared_ptr<domain::IRequests> requests, std::uint64_t version_number, const Transport::SnapshotOptions& options = {});
+
+        CatalogueVersion(const CatalogueVersion&) = delete;
+        CatalogueVersion& operator=(const CatalogueVersion&) = delete;
+
+        const std::uint64_t number;
+        // Источник, из которого построена версия: по нему отвечает запрос "Memory"
+        const std::shared_ptr<domain::IRequests> source;
+        const Transport::Catalogue catalogue;
+        const Render::RoutesMap routes_map;
+        const Transport::Router router;
+    };
+
+    /*
+    * Хранилище текущей версии каталога в стиле RCU.
+    * Писатель строит новую версию в стороне и публикует её атомарной заменой указателя.
+    * Читатель закрепляет версию на время одного запроса через Pin(); старая версия
+    * освобождается, когда её отпускает последний читатель.
+    */
+    class CatalogueHolder {
+    public:
+        CatalogueHolder() = default;
+        /* options — параметры снимков каталога для всех версий, собранных через Update */
+        explicit CatalogueHolder(const Transport::SnapshotOptions& options) : options_(options) {}
+
+        CatalogueHolder(const CatalogueHolder&) = delete;
+        CatalogueHolder& operator=(const CatalogueHolder&) = delete;
+
+        /* Текущая версия или nullptr, если ещё ничего не опубликовано */
+        std::shared_ptr<const CatalogueVersion> Pin() const;
+
+        /* Строит версию по запросам, не блокируя читателей, и публикует её; версия держит requests */
+        std::shared_ptr<const CatalogueVersion> Update(std::shared_ptr<domain::IRequests> requests);
+
+        /* Строит версию со следующим номером, не публикуя её */
+        std::shared_ptr<const CatalogueVersion> Build(std::shared_ptr<domain::IRequests> requests);
+
+        void Publish(std::shared_ptr<const CatalogueVersion> version);
+
+    private:
+        Transport::SnapshotOptions options_;
+        std::shared_ptr<const CatalogueVersion> current_;
+        std::atomic<std::uint64_t> next_version_number_{ 1 };
+        // Писатели публикуют версии строго по возрастанию номера
+        std::mutex writers_mutex_;
+    };
+
+    template<typename T>
+    T CreateResponses(
+        const domain::IRequests* request_ptr, 
+        const CatalogueVersion& version
+    ) {
+        return CreateResponses<T>(request_ptr, version.catalogue, version.routes_map, version.router);
+    };
+
+    /* Ответы в уже созданный приёмник, например пишущий в поток по мере готовности */
+    template<typename T>
+    void FillResponses(
+        const domain::IRequests* request_ptr, 
+        const CatalogueVersion& version,
+        T& responses
+    ) {
+        request_ptr->VisitStatRequests([&](const std::vector<domain::StatRequest>& requests) {
+            domain::ExecuteStatRequests(requests, *request_ptr, responses, version.catalogue, version.routes_map, version.router);
+        });
+    }
+
+    /*
+    * Отвечает на строки NDJSON: по одному JSON-объекту в строке. Ответ на каждую
+    * строку — строка JSON, сбрасываемая сразу, поэтому задержка не зависит от числа
+    * запросов. Версия каталога закрепляется для каждого запроса заново.
+    * Пустые строки пропускаются; на строку, которую не удалось разобрать,
+    * ответ {"error_message": ...}.
+    *
+    * Строка с ключом "base_requests" — новая база в том же виде, что и первая строка.
+    * Её строит фоновый писатель, а запросы тем временем обслуживаются прежней версией.
+    * Публикация и ответ {"base_version": n} идут под одной блокировкой вывода:
+    * ответы выше этой строки даны по прежней версии, ниже — по новой. Если базу
+    * построить не удалось, ответ {"error_message": ...}, и остаётся прежняя версия.
+    * Базы строятся по одной в порядке поступления.
+    */
+    class JsonLinesServer {
+    public:
+        /* thread_count — число потоков для построения версий по новым базам */
+        JsonLinesServer(CatalogueHolder& holder, std::ostream& output, std::size_t thread_count = 1);
+        ~JsonLinesServer();
+
+        JsonLinesServer(const JsonLinesServer&) = delete;
+        JsonLinesServer& operator=(const JsonLinesServer&) = delete;
+
+        void ServeLine(std::string_view line);
+
+        /* Дожидается публикации всех принятых баз и завершает вывод */
+        void Finish();
+
+    private:
+        void QueueBase(json::Document base);
+        void RunWriter();
+
+        CatalogueHolder& holder_;
+        std::size_t thread_count_;
+        std::vector<domain::StatRequest> requests_;
+
+        // Ответы пишут и цикл запросов, и писатель
+        std::mutex output_mutex_;
+        domain::JsonStreamResponses responses_;
+
+        std::mutex bases_mutex_;
+        std::condition_variable bases_ready_;
+        std::deque<json::Document> pending_bases_;
+        bool finishing_ = false;
+        // Запускается при первой новой базе
+        std::thread writer_;
+    };
+
+    /* Обслуживает строки input через JsonLinesServer, пока input не кончится */
+    void ServeJsonLines(
+        std::istream& input,
+        CatalogueHolder& holder,
+        std::ostream& output,
+        std::size_t thread_count = 1
+    );
+
 } // end RequestHandler 
\ No newline at end of file
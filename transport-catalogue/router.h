@@ -30,6 +30,23 @@ public:
 
     std::optional<RouteInfo> BuildRoute(VertexId from, VertexId to) const;
 
+    // Вес кратчайшего маршрута прямо из таблицы, без восстановления рёбер
+    std::optional<Weight> GetRouteWeight(VertexId from, VertexId to) const {
+        if (const auto& route_internal_data = routes_internal_data_.at(from).at(to)) {
+            return route_internal_data->weight;
+        }
+        return std::nullopt;
+    }
+
+    // Память таблицы маршрутов с учётом ёмкости векторов
+    std::size_t GetMemoryUsage() const {
+        std::size_t bytes = routes_internal_data_.capacity() * sizeof(typename RoutesInternalData::value_type);
+        for (const auto& row : routes_internal_data_) {
+            bytes += row.capacity() * sizeof(typename RoutesInternalData::value_type::value_type);
+        }
+        return bytes;
+    }
+
 private:
     struct RouteInternalData {
         Weight weight;
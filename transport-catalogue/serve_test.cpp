@@ -0,0 +1,175 @@
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "domain.h"
+#include "json.h"
+#include "request_handler.h"
+
+/*
+* Проверка JsonLinesServer: пока фоновый писатель строит новую базу, запросы
+* отвечаются по прежней версии, а строка {"base_version": n} отделяет ответы
+* по прежней версии от ответов по новой. Базы — две тестовые базы из test_data,
+* запросы — те их запросы к данным, ответ на которые по базам различается.
+*/
+
+namespace {
+
+std::string ReadFile(const std::string& path) {
+    std::ifstream input(path, std::ios::binary);
+    if (!input) {
+        throw std::runtime_error("Can't open " + path);
+    }
+    return { std::istreambuf_iterator<char>(input), std::istreambuf_iterator<char>() };
+}
+
+std::vector<std::string> SplitLines(const std::string& text) {
+    std::vector<std::string> lines;
+    std::istringstream input(text);
+    std::string line;
+    while (std::getline(input, line)) {
+        lines.push_back(line);
+    }
+    return lines;
+}
+
+/* Ответы версии с одной базой на каждую из строк */
+std::vector<std::string> Answer(const std::string& base, const std::vector<std::string>& lines) {
+    RequestHandler::CatalogueHolder holder;
+    holder.Update(std::make_shared<domain::JsonRequests>(std::string_view(base)));
+    std::ostringstream output;
+    RequestHandler::JsonLinesServer server(holder, output);
+    for (const std::string& line : lines) {
+        server.ServeLine(line);
+    }
+    server.Finish();
+    return SplitLines(output.str());
+}
+
+/* Запросы к данным базы, кроме карты и памяти: их ответы зависят не только от базы */
+std::vector<std::string> GetQueries(const std::string& base) {
+    std::vector<std::string> queries;
+    const json::Document document = json::Load(std::string_view(base));
+    for (const json::Node& node : document.GetRoot().AsDict().at("stat_requests").AsArray()) {
+        const std::string& type = node.AsDict().at("type").AsString();
+        if (type == "Map" || type == "Memory") {
+            continue;
+        }
+        std::ostringstream line;
+        json::Writer(line, true).Value(node);
+        queries.push_back(line.str());
+    }
+    return queries;
+}
+
+struct Query {
+    std::string line;
+    std::string old_answer;
+    std::string new_answer;
+};
+
+int failures = 0;
+
+void Check(bool condition, const std::string& message) {
+    if (!condition) {
+        std::cerr << message << std::endl;
+        ++failures;
+    }
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+    const std::string old_base = ReadFile(argc > 1 ? argv[1] : "../test_data/s12_final_opentest_1.json");
+    const std::string new_base = ReadFile(argc > 2 ? argv[2] : "../test_data/s12_final_opentest_3.json");
+
+    std::vector<std::string> candidates = GetQueries(old_base);
+    const std::vector<std::string> new_base_queries = GetQueries(new_base);
+    candidates.insert(candidates.end(), new_base_queries.begin(), new_base_queries.end());
+    const std::vector<std::string> old_answers = Answer(old_base, candidates);
+    const std::vector<std::string> new_answers = Answer(new_base, candidates);
+    if (old_answers.size() != candidates.size() || new_answers.size() != candidates.size()) {
+        std::cerr << "One answer per query line expected" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::vector<Query> queries;
+    for (std::size_t i = 0; i < candidates.size(); ++i) {
+        if (old_answers[i] != new_answers[i]) {
+            queries.push_back({ candidates[i], old_answers[i], new_answers[i] });
+        }
+    }
+    if (queries.empty()) {
+        std::cerr << "No queries tell the bases apart" << std::endl;
+        return EXIT_FAILURE;
+    }
+
+    /* Запросы идут, пока новая база строится, и ещё один круг после её публикации */
+    RequestHandler::CatalogueHolder holder;
+    const std::uint64_t old_version = holder.Update(std::make_shared<domain::JsonRequests>(std::string_view(old_base)))->number;
+    std::ostringstream output;
+    std::vector<const Query*> sent;
+    {
+        RequestHandler::JsonLinesServer server(holder, output);
+        server.ServeLine(new_base);
+        for (std::size_t i = 0; holder.Pin()->number == old_version; i = (i + 1) % queries.size()) {
+            server.ServeLine(queries[i].line);
+            sent.push_back(&queries[i]);
+        }
+        for (const Query& query : queries) {
+            server.ServeLine(query.line);
+            sent.push_back(&query);
+        }
+        server.Finish();
+    }
+
+    const std::vector<std::string> lines = SplitLines(output.str());
+    const std::string published = "{\"base_version\":" + std::to_string(holder.Pin()->number) + "}";
+    std::size_t answers_before = 0;
+    std::size_t answers_after = 0;
+    bool is_published = false;
+    std::size_t next_query = 0;
+    for (const std::string& line : lines) {
+        if (line == published) {
+            Check(!is_published, "Base version is reported twice");
+            is_published = true;
+            continue;
+        }
+        if (next_query == sent.size()) {
+            Check(false, "Unexpected line: " + line);
+            continue;
+        }
+        const Query& query = *sent[next_query++];
+        if (is_published) {
+            Check(line == query.new_answer, "After publication, answer by the old base: " + line);
+            ++answers_after;
+        } else {
+            Check(line == query.old_answer, "Before publication, answer by the new base: " + line);
+            ++answers_before;
+        }
+    }
+    Check(is_published, "Base version is not reported");
+    Check(next_query == sent.size(), "Not every query is answered");
+    Check(holder.Pin()->number != old_version, "New base is not published");
+    Check(answers_before > 0, "No query is answered while the new base is built");
+
+    /* Базу, которую не удалось построить, заменяет ошибка, а версия остаётся прежней */
+    {
+        const std::uint64_t current_version = holder.Pin()->number;
+        std::ostringstream broken_output;
+        RequestHandler::JsonLinesServer server(holder, broken_output);
+        server.ServeLine(R"({"base_requests": [{"type": "Bus", "name": "x", "stops": ["nope"], "is_roundtrip": true}], )"
+            R"("render_settings": {}, "routing_settings": {"bus_wait_time": 1, "bus_velocity": 1}})");
+        server.Finish();
+        Check(broken_output.str().find("error_message") != std::string::npos, "Broken base is not reported");
+        Check(holder.Pin()->number == current_version, "Broken base replaced the version");
+    }
+
+    std::cout << "serve_test: " << queries.size() << " queries, " << answers_before << " answered during the update, "
+        << answers_after << " after, " << failures << " failures" << std::endl;
+    return failures == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
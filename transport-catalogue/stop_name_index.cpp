@@ -0,0 +1,159 @@
+#include <algorithm>
+#include <tuple>
+
+#include "stop_name_index.h"
+
+namespace Transport {
+
+namespace {
+
+/* Символы сравниваются как unsigned char — так же, как при сортировке std::string_view */
+unsigned char At(std::string_view str, std::size_t pos) {
+    return static_cast<unsigned char>(str[pos]);
+}
+
+} // namespace
+
+StopNameIndex::StopNameIndex(const std::vector<std::string_view>& names) : names_(names) {
+    Node root;
+    root.end = static_cast<std::uint32_t>(names_.size());
+    nodes_.push_back(root);
+    Build(0);
+}
+
+void StopNameIndex::Build(std::uint32_t node_index) {
+    const Node node = nodes_[node_index];
+    std::uint32_t i = node.begin;
+    // Имя, совпадающее с путём до узла, в отсортированном диапазоне идёт первым
+    if (i < node.end && names_[i].size() == node.depth) {
+        ++i;
+    }
+
+    const std::uint32_t children_begin = static_cast<std::uint32_t>(nodes_.size());
+    while (i < node.end) {
+        const unsigned char c = At(names_[i], node.depth);
+        std::uint32_t j = i + 1;
+        while (j < node.end && At(names_[j], node.depth) == c) {
+            ++j;
+        }
+        /* Общий префикс группы — общий префикс её первого и последнего имени */
+        std::string_view first = names_[i];
+        std::string_view last = names_[j - 1];
+        std::size_t depth = node.depth + 1;
+        while (depth < first.size() && depth < last.size() && first[depth] == last[depth]) {
+            ++depth;
+        }
+
+        Node child;
+        child.label = first.substr(node.depth, depth - node.depth);
+        child.depth = static_cast<std::uint32_t>(depth);
+        child.begin = i;
+        child.end = j;
+        nodes_.push_back(child);
+        i = j;
+    }
+    const std::uint32_t children_end = static_cast<std::uint32_t>(nodes_.size());
+    nodes_[node_index].children_begin = children_begin;
+    nodes_[node_index].children_end = children_end;
+
+    for (std::uint32_t child = children_begin; child < children_end; ++child) {
+        Build(child);
+    }
+}
+
+bool StopNameIndex::IsTerminal(const Node& node) const {
+    return node.begin < node.end && names_[node.begin].size() == node.depth;
+}
+
+std::vector<std::uint32_t> StopNameIndex::Search(std::string_view prefix, std::size_t limit, std::size_t max_edits) const {
+    if (max_edits == 0) {
+        return SearchExact(prefix, limit);
+    }
+
+    std::vector<std::size_t> row(prefix.size() + 1);
+    for (std::size_t j = 0; j < row.size(); ++j) {
+        row[j] = j;
+    }
+    std::vector<Match> matches;
+    SearchFuzzy(nodes_.front(), prefix, max_edits, std::move(row), prefix.size(), matches);
+
+    std::sort(matches.begin(), matches.end(), [](const Match& lhs, const Match& rhs) {
+        return std::tie(lhs.edits, lhs.begin) < std::tie(rhs.edits, rhs.begin);
+    });
+    std::vector<std::uint32_t> result;
+    for (const Match& match : matches) {
+        for (std::uint32_t id = match.begin; id < match.end && result.size() < limit; ++id) {
+            result.push_back(id);
+        }
+    }
+    return result;
+}
+
+std::vector<std::uint32_t> StopNameIndex::SearchExact(std::string_view prefix, std::size_t limit) const {
+    const Node* node = &nodes_.front();
+    std::size_t pos = 0;
+    while (pos < prefix.size()) {
+        auto children_begin = nodes_.begin() + node->children_begin;
+        auto children_end = nodes_.begin() + node->children_end;
+        auto child = std::lower_bound(children_begin, children_end, At(prefix, pos), [](const Node& child, unsigned char c) {
+            return At(child.label, 0) < c;
+        });
+        if (child == children_end || At(child->label, 0) != At(prefix, pos)) {
+            return {};
+        }
+        const std::size_t length = std::min(child->label.size(), prefix.size() - pos);
+        if (child->label.substr(0, length) != prefix.substr(pos, length)) {
+            return {};
+        }
+        pos += length;
+        node = &*child;
+    }
+
+    std::vector<std::uint32_t> result;
+    for (std::uint32_t id = node->begin; id < node->end && result.size() < limit; ++id) {
+        result.push_back(id);
+    }
+    return result;
+}
+
+/*
+* Обход дерева со строкой таблицы Левенштейна: row[j] — расстояние между путём
+* до текущего символа и первыми j символами префикса, best — наименьшее
+* расстояние от префикса запроса до префикса пути.
+*/
+void StopNameIndex::SearchFuzzy(const Node& node, std::string_view prefix, std::size_t max_edits,
+    std::vector<std::size_t> row, std::size_t best, std::vector<Match>& matches) const {
+    for (const char c : node.label) {
+        std::size_t diagonal = row[0];
+        row[0] += 1;
+        std::size_t min_row = row[0];
+        for (std::size_t j = 1; j < row.size(); ++j) {
+            const std::size_t above = row[j];
+            row[j] = std::min({ row[j] + 1, row[j - 1] + 1, diagonal + (prefix[j - 1] != c ? 1 : 0) });
+            diagonal = above;
+            min_row = std::min(min_row, row[j]);
+        }
+        best = std::min(best, row.back());
+
+        /* Дальше по пути расстояние не станет меньше min_row: всё поддерево решено */
+        if (min_row >= best || min_row > max_edits) {
+            if (best <= max_edits) {
+                matches.push_back({ best, node.begin, node.end });
+            }
+            return;
+        }
+    }
+
+    if (IsTerminal(node) && best <= max_edits) {
+        matches.push_back({ best, node.begin, node.begin + 1 });
+    }
+    for (std::uint32_t child = node.children_begin; child < node.children_end; ++child) {
+        SearchFuzzy(nodes_[child], prefix, max_edits, row, best, matches);
+    }
+}
+
+std::size_t StopNameIndex::GetMemoryUsage() const {
+    return names_.capacity() * sizeof(std::string_view) + nodes_.capacity() * sizeof(Node);
+}
+
+} // end Transport
@@ -0,0 +1,59 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+
+namespace Transport {
+
+/*
+* Сжатое префиксное дерево над отсортированными именами остановок.
+* Имя остановки — её идентификатор в снимке, поэтому поддерево узла
+* покрывает непрерывный диапазон идентификаторов [begin, end).
+* Поиск по префиксу проходит только символы префикса и не зависит от числа остановок.
+*/
+class StopNameIndex {
+public:
+    StopNameIndex() = default;
+    /* names — имена, отсортированные по возрастанию; строки должны пережить индекс */
+    explicit StopNameIndex(const std::vector<std::string_view>& names);
+
+    /*
+    * До limit остановок, у которых некоторый префикс имени отличается от prefix
+    * не более чем на max_edits правок (вставка, удаление, замена символа).
+    * Результат упорядочен по числу правок, затем по имени.
+    */
+    std::vector<std::uint32_t> Search(std::string_view prefix, std::size_t limit, std::size_t max_edits = 0) const;
+
+    std::size_t GetMemoryUsage() const;
+
+private:
+    struct Node {
+        std::string_view label;           // метка ребра от родителя
+        std::uint32_t depth = 0;          // длина пути от корня с учётом метки
+        std::uint32_t begin = 0;          // диапазон идентификаторов поддерева
+        std::uint32_t end = 0;
+        std::uint32_t children_begin = 0; // дети лежат подряд и упорядочены по первому символу метки
+        std::uint32_t children_end = 0;
+    };
+
+    /* Диапазон идентификаторов, найденный с заданным числом правок */
+    struct Match {
+        std::size_t edits;
+        std::uint32_t begin;
+        std::uint32_t end;
+    };
+
+    void Build(std::uint32_t node_index);
+    bool IsTerminal(const Node& node) const;
+
+    std::vector<std::uint32_t> SearchExact(std::string_view prefix, std::size_t limit) const;
+    void SearchFuzzy(const Node& node, std::string_view prefix, std::size_t max_edits,
+        std::vector<std::size_t> row, std::size_t best, std::vector<Match>& matches) const;
+
+    std::vector<std::string_view> names_;
+    std::vector<Node> nodes_;
+};
+
+} // end Transport
@@ -1,4 +1,5 @@
 #include "svg.h"
+#include "number_format.h"
 
 namespace svg {
 
@@ -6,18 +7,18 @@ using namespace std::literals;
 
 std::ostream& operator<<(std::ostream& out, Rgb rgb) {
     out << "rgb("sv;
-    out << static_cast<int>(rgb.red) << ","sv;
-    out << static_cast<int>(rgb.green) << ","sv;
-    out << static_cast<int>(rgb.blue) << ")"sv;
+    out << format::Int{ rgb.red } << ","sv;
+    out << format::Int{ rgb.green } << ","sv;
+    out << format::Int{ rgb.blue } << ")"sv;
     return out;
 }
 
 std::ostream& operator<<(std::ostream& out, Rgba rgba) {
     out << "rgb("sv;
-    out << static_cast<int>(rgba.red) << ","sv;
-    out << static_cast<int>(rgba.green) << ","sv;
-    out << static_cast<int>(rgba.blue) << ","sv;
-    out << rgba.opacity << ")"sv;
+    out << format::Int{ rgba.red } << ","sv;
+    out << format::Int{ rgba.green } << ","sv;
+    out << format::Int{ rgba.blue } << ","sv;
+    out << format::Double{ rgba.opacity } << ")"sv;
     return out;
 }
 
@@ -65,24 +66,6 @@ std::string escapeSpecialCharacters(const std::string& text) {
     return result;
 }
 
-void Object::Render(const RenderContext& context) const {
-    context.RenderIndent();
-
-    // Делегируем вывод тега своим подклассам
-    RenderObject(context);
-
-    context.out << std::endl;
-}
-
-// ---------- ObjectContainter ------------------
-
-// template <typename T>
-// void ObjectContainer::Add(T obj) {
-//     objects_.emplace_back(std::make_unique(std::move(obj)));
-// }
-
-// ---------- Drawable ------------------
-
 // ---------- Circle ------------------
 
 Circle& Circle::SetCenter(Point center)  {
@@ -95,36 +78,12 @@ Circle& Circle::SetRadius(double radius)  {
     return *this;
 }
 
-void Circle::RenderObject(const RenderContext& context) const {
-    auto& out = context.out;
-    out << "<circle cx=\""sv << center_.x << "\" cy=\""sv << center_.y << "\" "sv;
-    out << "r=\""sv << radius_ << "\" "sv;
-    RenderAttrs(context.out);
-    out << "/>"sv;
-}
-
 // ---------- Polyline ------------------
 Polyline& Polyline::AddPoint(Point point) {
     points_.push_back(point);
     return *this;
 }
 
-void Polyline::RenderObject(const RenderContext& context) const {
-    std::ostream& out = context.out;
-    out << "<polyline points=\""sv;
-    bool is_first = true;
-    for (Point p : points_) {
-        if (is_first) {
-            out << p.x << ',' << p.y;
-            is_first = false;
-        } else {
-            out << ' ' << p.x << ',' << p.y;
-        }
-    }
-    out << "\""sv;
-    RenderAttrs(context.out);
-    out << "/>"sv; 
-}
 // ---------- Text ------------------
 
 Text& Text::SetPosition(Point pos) {
@@ -144,48 +103,183 @@ Text& Text::SetFontSize(uint32_t size) {
     return *this;
 }
 
-    Text& Text::SetFontFamily(std::string font_family) {
-        font_family_ = std::move(font_family);
-        return *this;
+Text& Text::SetFontFamily(std::string font_family) {
+    font_family_ = std::move(font_family);
+    return *this;
+}
+
+Text& Text::SetFontWeight(std::string font_weight) {
+    font_weight_ = std::move(font_weight);
+    return *this;
+}
+
+Text& Text::SetData(std::string data) {
+    data_ = std::move(data);
+    return *this;
+}
+
+// ---------- Document ------------------
+
+StyleId Document::AddStyle(Style style) {
+    styles_.push_back(std::move(style));
+    return static_cast<StyleId>(styles_.size() - 1);
+}
+
+StringRef Document::AddString(std::string_view value) {
+    const StringRef ref{ static_cast<std::uint32_t>(strings_.size()), static_cast<std::uint32_t>(value.size()) };
+    strings_.append(value);
+    return ref;
+}
+
+std::string_view Document::GetString(StringRef ref) const {
+    return std::string_view(strings_).substr(ref.offset, ref.size);
+}
+
+void Document::AddToRun(ShapeKind kind) {
+    if (runs_.empty() || runs_.back().kind != kind) {
+        runs_.push_back({ kind, 0 });
     }
+    ++runs_.back().count;
+}
+
+void Document::AddCircle(const CircleShape& circle) {
+    circles_.push_back(circle);
+    AddToRun(ShapeKind::Circle);
+}
 
-    Text& Text::SetFontWeight(std::string font_weight) {
-        font_weight_ = std::move(font_weight);
-        return *this;
+void Document::StartPolyline(StyleId style) {
+    polylines_.push_back({ static_cast<std::uint32_t>(points_.size()), 0, style });
+    AddToRun(ShapeKind::Polyline);
+}
+
+void Document::AddPolylinePoint(Point point) {
+    points_.push_back(point);
+    ++polylines_.back().points_count;
+}
+
+void Document::AddText(const TextShape& text) {
+    texts_.push_back(text);
+    AddToRun(ShapeKind::Text);
+}
+
+void Document::Add(const Circle& circle) {
+    AddCircle({ circle.center_, circle.radius_, AddStyle(circle.GetStyle()) });
+}
+
+void Document::Add(const Polyline& polyline) {
+    StartPolyline(AddStyle(polyline.GetStyle()));
+    for (Point point : polyline.points_) {
+        AddPolylinePoint(point);
     }
+}
+
+void Document::Add(const Text& text) {
+    TextShape shape;
+    shape.position = text.pos_;
+    shape.offset = text.offset_;
+    shape.font_size = text.size_;
+    shape.font_family = AddString(text.font_family_);
+    shape.font_weight = AddString(text.font_weight_);
+    shape.data = AddString(text.data_);
+    shape.style = AddStyle(text.GetStyle());
+    AddText(shape);
+}
 
-    Text& Text::SetData(std::string data) {
-        data_ = std::move(data);
-        return *this;
+// Выводит общие для всех путей атрибуты fill и stroke
+void Document::RenderStyle(std::ostream& out, StyleId style_id) const {
+    const Style& style = styles_[style_id];
+    if (style.line_join) {
+        out << " stroke-linejoin=\""sv << *style.line_join << "\""sv;
+    }
+    if (style.stroke_width) {
+        out << " stroke-width=\""sv << format::Double{ *style.stroke_width } << "\""sv;
     }
-    
-    void Text::RenderObject(const RenderContext& context) const {
-        auto& out = context.out;
-        out << "<text";
-        RenderAttrs(context.out);
-        out << " x=\""sv << pos_.x << "\" y=\""sv << pos_.y << "\" "sv;
-        out << "dx=\""sv << offset_.x << "\" dy=\""sv << offset_.y << "\" "sv;
-        out << "font-size=\""sv << size_ << "\""sv;
-        if (!font_family_.empty()) out << " font-family=\""sv << font_family_ << "\" "sv;
-        if (!font_weight_.empty()) out << "font-weight=\""sv << font_weight_ << "\""sv;
-        out << ">"sv << data_ << "</text>"sv;
+    if (style.line_cap) {
+        out << " stroke-linecap=\""sv << *style.line_cap << "\""sv;
     }
+    if (style.fill_color) {
+        out << " fill=\""sv;
+        std::visit(ColorOutput{out}, *style.fill_color);
+        out << "\""sv;
+    }
+    if (style.stroke_color) {
+        out << " stroke=\""sv;
+        std::visit(ColorOutput{out}, *style.stroke_color);
+        out << "\""sv;
+    }
+}
 
+void Document::RenderCircle(std::ostream& out, const CircleShape& circle) const {
+    out << "<circle cx=\""sv << format::Double{ circle.center.x } << "\" cy=\""sv << format::Double{ circle.center.y } << "\" "sv;
+    out << "r=\""sv << format::Double{ circle.radius } << "\" "sv;
+    RenderStyle(out, circle.style);
+    out << "/>"sv;
+}
 
-// ---------- Document ------------------
+void Document::RenderPolyline(std::ostream& out, const PolylineShape& polyline) const {
+    out << "<polyline points=\""sv;
+    for (std::uint32_t i = 0; i < polyline.points_count; ++i) {
+        const Point p = points_[polyline.points_begin + i];
+        if (i > 0) {
+            out.put(' ');
+        }
+        out << format::Double{ p.x } << ',' << format::Double{ p.y };
+    }
+    out << "\""sv;
+    RenderStyle(out, polyline.style);
+    out << "/>"sv;
+}
 
-void Document::AddPtr(std::unique_ptr<Object>&& obj) {
-    objects_.emplace_back(std::move(obj));
+void Document::RenderText(std::ostream& out, const TextShape& text) const {
+    out << "<text"sv;
+    RenderStyle(out, text.style);
+    out << " x=\""sv << format::Double{ text.position.x } << "\" y=\""sv << format::Double{ text.position.y } << "\" "sv;
+    out << "dx=\""sv << format::Double{ text.offset.x } << "\" dy=\""sv << format::Double{ text.offset.y } << "\" "sv;
+    out << "font-size=\""sv << format::Int{ text.font_size } << "\""sv;
+    if (text.font_family.size > 0) out << " font-family=\""sv << GetString(text.font_family) << "\" "sv;
+    if (text.font_weight.size > 0) out << "font-weight=\""sv << GetString(text.font_weight) << "\""sv;
+    out << ">"sv << GetString(text.data) << "</text>"sv;
 }
 
 void Document::Render(std::ostream& output) const {
+    RenderBegin(output);
+    RenderShapes(output);
+    RenderEnd(output);
+}
+
+void Document::RenderBegin(std::ostream& output) {
+    output << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>\n"sv;
+    output << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">\n"sv;
+}
+
+void Document::RenderEnd(std::ostream& output) {
+    output << "</svg>"sv;
+}
+
+void Document::RenderShapes(std::ostream& output) const {
     RenderContext ctx{output, 2, 2};
-    output << "<?xml version=\"1.0\" encoding=\"UTF-8\" ?>"sv << std::endl;
-    output << "<svg xmlns=\"http://www.w3.org/2000/svg\" version=\"1.1\">"sv << std::endl;
-    for (const auto& obj : objects_) {
-        obj->Render(ctx);
+    // Серии обходят массивы фигур по порядку добавления
+    std::size_t circle = 0;
+    std::size_t polyline = 0;
+    std::size_t text = 0;
+    for (const Run& run : runs_) {
+        for (std::uint32_t i = 0; i < run.count; ++i) {
+            ctx.RenderIndent();
+            switch (run.kind) {
+                case ShapeKind::Circle:
+                    RenderCircle(output, circles_[circle++]);
+                    break;
+                case ShapeKind::Polyline:
+                    RenderPolyline(output, polylines_[polyline++]);
+                    break;
+                case ShapeKind::Text:
+                    RenderText(output, texts_[text++]);
+                    break;
+            }
+            // Перевод строки без сброса потока на каждом элементе
+            output.put('\n');
+        }
     }
-    output << "</svg>"sv;
 }
 
 }  // namespace svg
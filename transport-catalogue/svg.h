@@ -3,11 +3,13 @@
 
 #include <cstdint>
 #include <iostream>
-#include <memory>
 #include <optional>
 #include <variant>
-#include <vector>
 #include <string>
+#include <string_view>
+#include <vector>
+
+#include "number_format.h"
 
 namespace svg {
 
@@ -45,12 +47,12 @@ struct ColorOutput{
     void operator()(std::string color) const { out << color; }
     void operator()(Rgb color) const {
         out << "rgb("
-            << static_cast<int>(color.red) << "," << static_cast<int>(color.green) << "," << static_cast<int>(color.blue)
+            << format::Int{ color.red } << "," << format::Int{ color.green } << "," << format::Int{ color.blue }
             << ")";
     }
     void operator()(Rgba color) const {
         out << "rgba("
-            << static_cast<int>(color.red) << "," << static_cast<int>(color.green) << "," << static_cast<int>(color.blue) << "," << color.opacity
+            << format::Int{ color.red } << "," << format::Int{ color.green } << "," << format::Int{ color.blue } << "," << format::Double{ color.opacity }
             << ")";
     }
 };
@@ -87,58 +89,49 @@ struct Point {
     double y = 0;
 };
 
+/* Номер общей записи стиля в документе */
+using StyleId = std::uint32_t;
+
+/* Атрибуты fill и stroke; одна запись разделяется многими фигурами документа */
+struct Style {
+    std::optional<Color> fill_color;
+    std::optional<Color> stroke_color;
+    std::optional<double> stroke_width;
+    std::optional<StrokeLineCap> line_cap;
+    std::optional<StrokeLineJoin> line_join;
+};
+
 template <typename Owner>
 class PathProps {
 public:
     Owner& SetFillColor(Color color) {
-        fill_color_ = std::move(color);
+        style_.fill_color = std::move(color);
         return AsOwner();
     }
     Owner& SetStrokeColor(Color color) {
-        stroke_color_ = std::move(color);
+        style_.stroke_color = std::move(color);
         return AsOwner();
     }
     Owner& SetStrokeWidth(double width) {
-        width_ = std::move(width);
+        style_.stroke_width = width;
         return AsOwner();
     }
     Owner& SetStrokeLineCap(StrokeLineCap line_cap) {
-        line_cap_ = line_cap;
+        style_.line_cap = line_cap;
         return AsOwner();
     }
     Owner& SetStrokeLineJoin(StrokeLineJoin line_join) {
-        line_join_ = line_join;
+        style_.line_join = line_join;
         return AsOwner();
     }
 
+    const Style& GetStyle() const {
+        return style_;
+    }
+
 protected:
     ~PathProps() = default;
 
-    // Метод RenderAttrs выводит в поток общие для всех путей атрибуты fill и stroke
-    void RenderAttrs(std::ostream& out) const {
-        using namespace std::literals;
-
-        if (line_join_) {
-            out << " stroke-linejoin=\""sv << *line_join_ << "\""sv;
-        }
-        if (width_) {
-            out << " stroke-width=\""sv << *width_ << "\""sv;
-        }
-        if (line_cap_) {
-            out << " stroke-linecap=\""sv << *line_cap_ << "\""sv;
-        }
-        if (fill_color_) {
-            out << " fill=\""sv;
-            std::visit(ColorOutput{out}, *fill_color_);
-            out << "\""sv;
-        }
-        if (stroke_color_) {
-            out << " stroke=\""sv;
-            std::visit(ColorOutput{out}, *stroke_color_);
-            out << "\""sv;
-        }
-    }
-
 private:
     Owner& AsOwner() {
         // static_cast безопасно преобразует *this к Owner&,
@@ -146,11 +139,7 @@ private:
         return static_cast<Owner&>(*this);
     }
 
-    std::optional<Color> fill_color_;
-    std::optional<Color> stroke_color_;
-    std::optional<double> width_;
-    std::optional<StrokeLineCap> line_cap_;
-    std::optional<StrokeLineJoin> line_join_;
+    Style style_;
 };
 
 /*
@@ -183,57 +172,48 @@ struct RenderContext {
     int indent = 0;
 };
 
-/*
- * Абстрактный базовый класс Object служит для унифицированного хранения
- * конкретных тегов SVG-документа
- * Реализует паттерн "Шаблонный метод" для вывода содержимого тега
- */
-class Object {
-public:
-    void Render(const RenderContext& context) const;
-
-    virtual ~Object() = default;
-
-private:
-    virtual void RenderObject(const RenderContext& context) const = 0;
+/* Ссылка на строку в буфере строк документа */
+struct StringRef {
+    std::uint32_t offset = 0;
+    std::uint32_t size = 0;
 };
 
-class ObjectContainer {
-public:
-    template <typename T>
-    void Add(T obj) {
-        AddPtr(std::make_unique<T>(std::move(obj)));
-    }
-
-    virtual void AddPtr(std::unique_ptr<Object>&& obj) = 0;
+/* Круг в документе */
+struct CircleShape {
+    Point center;
+    double radius = 1.0;
+    StyleId style = 0;
+};
 
-protected:
-    ~ObjectContainer() = default;
-    std::vector<std::unique_ptr<Object>> objects_;
+/* Ломаная в документе: вершины — [points_begin, +points_count) в общем массиве вершин */
+struct PolylineShape {
+    std::uint32_t points_begin = 0;
+    std::uint32_t points_count = 0;
+    StyleId style = 0;
 };
 
-/*
-* Интерфейс Drawable унифицирует работу с объектами, которые можно нарисовать,
-* подключив SVG-библиотеку. Для этого в нём есть метод Draw, принимающий ссылку
-* на интерфейс ObjectContainer
-*/
-class Drawable {
-public:
-    virtual ~Drawable() = default;
-    virtual void Draw(ObjectContainer& container) const = 0;
+/* Надпись в документе; пустые font_family и font_weight не выводятся */
+struct TextShape {
+    Point position;
+    Point offset;
+    std::uint32_t font_size = 1;
+    StringRef font_family;
+    StringRef font_weight;
+    StringRef data;
+    StyleId style = 0;
 };
 
 /*
  * Класс Circle моделирует элемент <circle> для отображения круга
  * https://developer.mozilla.org/en-US/docs/Web/SVG/Element/circle
  */
-class Circle final : public Object, public PathProps<Circle> {
+class Circle final : public PathProps<Circle> {
 public:
     Circle& SetCenter(Point center);
     Circle& SetRadius(double radius);
 
 private:
-    void RenderObject(const RenderContext& context) const override;
+    friend class Document;
 
     Point center_;
     double radius_ = 1.0;
@@ -243,18 +223,14 @@ private:
  * Класс Polyline моделирует элемент <polyline> для отображения ломаных линий
  * https://developer.mozilla.org/en-US/docs/Web/SVG/Element/polyline
  */
-class Polyline final : public Object, public PathProps<Polyline> {
+class Polyline final : public PathProps<Polyline> {
 public:
     // Добавляет очередную вершину к ломаной линии
     Polyline& AddPoint(Point point);
 
-
-
-    /*
-     * Прочие методы и данные, необходимые для реализации элемента <polyline>
-     */
 private:
-    void RenderObject(const RenderContext& context) const override;
+    friend class Document;
+
     std::vector<Point> points_;
 };
 
@@ -262,7 +238,7 @@ private:
  * Класс Text моделирует элемент <text> для отображения текста
  * https://developer.mozilla.org/en-US/docs/Web/SVG/Element/text
  */
-class Text final : public Object, public PathProps<Text> {
+class Text final : public PathProps<Text> {
 public:
     // Задаёт координаты опорной точки (атрибуты x и y)
     Text& SetPosition(Point pos);
@@ -282,11 +258,8 @@ public:
     // Задаёт текстовое содержимое объекта (отображается внутри тега text)
     Text& SetData(std::string data);
 
-    // Прочие данные и методы, необходимые для реализации элемента <text>
 private:
-
-    void RenderObject(const RenderContext& context) const override;
-    
+    friend class Document;
 
     Point pos_ = {0, 0};
     Point offset_ = {0, 0};
@@ -296,20 +269,67 @@ private:
     std::string data_;
 };
 
-class Document : public ObjectContainer {
+/*
+ * SVG-документ в плотном виде: фигуры хранятся по видам в непрерывных массивах,
+ * стили — общими записями по номеру, строки надписей — в одном буфере.
+ * Порядок вывода между видами задают серии подряд добавленных фигур одного вида.
+ * Документ из тысяч фигур обходится несколькими выделениями памяти.
+ */
+class Document {
 public:
-    /**
-     * Добавляет в svg-документ объект-наследник svg::Object
-    */
-    void AddPtr(std::unique_ptr<Object>&& obj) override;
+    /* Добавляет запись стиля, на которую ссылаются фигуры */
+    StyleId AddStyle(Style style);
+    /* Копирует строку в буфер документа; ссылку можно давать многим надписям */
+    StringRef AddString(std::string_view value);
+
+    void AddCircle(const CircleShape& circle);
+    /* Начинает ломаную; её вершины добавляет AddPolylinePoint */
+    void StartPolyline(StyleId style);
+    void AddPolylinePoint(Point point);
+    void AddText(const TextShape& text);
+
+    /* Отдельно собранные фигуры: стиль и строки копируются в документ */
+    void Add(const Circle& circle);
+    void Add(const Polyline& polyline);
+    void Add(const Text& text);
 
     /**
      * Выводит в ostream svg-представление документа
     */
     void Render(std::ostream& out) const;
 
+    /*
+     * Части Render для сборки одного документа из нескольких: пролог с открывающим
+     * тегом <svg>, только элементы документа и закрывающий тег
+     */
+    static void RenderBegin(std::ostream& out);
+    void RenderShapes(std::ostream& out) const;
+    static void RenderEnd(std::ostream& out);
+
 private:
-    std::vector<std::unique_ptr<Object>> objects_;
+    enum class ShapeKind : std::uint8_t { Circle, Polyline, Text };
+
+    /* Подряд добавленные фигуры одного вида */
+    struct Run {
+        ShapeKind kind;
+        std::uint32_t count;
+    };
+
+    void AddToRun(ShapeKind kind);
+    std::string_view GetString(StringRef ref) const;
+
+    void RenderStyle(std::ostream& out, StyleId style) const;
+    void RenderCircle(std::ostream& out, const CircleShape& circle) const;
+    void RenderPolyline(std::ostream& out, const PolylineShape& polyline) const;
+    void RenderText(std::ostream& out, const TextShape& text) const;
+
+    std::vector<Style> styles_;
+    std::string strings_;
+    std::vector<CircleShape> circles_;
+    std::vector<PolylineShape> polylines_;
+    std::vector<Point> points_;
+    std::vector<TextShape> texts_;
+    std::vector<Run> runs_;
 };
 
 }  // namespace svg
\ No newline at end of file
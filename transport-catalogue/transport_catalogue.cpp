@@ -1,6 +1,8 @@
+#include <algorithm>
 #include <memory>
 #include <string>
 
+#include "catalogue_snapshot.h"
 #include "transport_catalogue.h"
 
 namespace Transport { 
@@ -19,6 +21,10 @@ const Geo::Coordinates& Stop::GetCoordinates() const {
     return coordinates_;
 }
 
+const Geo::LatitudeTrig& Stop::GetLatitudeTrig() const {
+    return latitude_trig_;
+}
+
 bool Stop::operator==(const Stop* other) const {
     return other->name_ == name_;
 }
@@ -74,6 +80,14 @@ const std::set<std::string_view>& Stop::GetBusNames() const {
     return sorted_bus_names_;
 }
 
+std::size_t Stop::GetMemoryUsage() const {
+    return memory::SHARED_CONTROL_BLOCK + sizeof(Stop)
+        + memory::GetHeapBytes(name_)
+        + memory::GetHeapBytes(unique_buses_)
+        + memory::GetHeapBytes(distance_to_adjacent_stops_)
+        + memory::GetHeapBytes(sorted_bus_names_);
+}
+
 std::size_t StopHasher::operator()(const std::weak_ptr<Stop>& stop_ptr) const {
     if (auto shared_stop = stop_ptr.lock()) {
         return std::hash<std::string>{}(shared_stop->GetName());
@@ -142,20 +156,46 @@ std::size_t Bus::GetSize() const {
     return size_;
 }
 
-std::vector<std::weak_ptr<Stop>> Bus::GetUniqueStops() {
-    return {unique_stops_.begin(), unique_stops_.end()};
-}
-
 const std::string& Bus::GetName() const {
     return name_;
 }
 
+std::size_t Bus::GetMemoryUsage() const {
+    return memory::SHARED_CONTROL_BLOCK + sizeof(Bus)
+        + memory::GetHeapBytes(name_)
+        + size_ * sizeof(RouteNode);
+}
+
+void Bus::ReleaseRoute() {
+    RouteNode* current = start_;
+    while (current != nullptr) {
+        RouteNode* temp = current;
+        current = current->next;
+        delete temp;
+    }
+    start_ = nullptr;
+    end_ = nullptr;
+    size_ = 0;
+    last_stop_.reset();
+}
+
 RouteType Bus::GetType() const {
     return type_;
 }
 
 void Bus::AddStop(std::shared_ptr<Stop> stop) {
-    unique_stops_.insert(stop);
+    AppendStop(stop);
+    stop->AddBus(shared_from_this());
+}
+
+void Bus::RegisterOnStops() {
+    std::shared_ptr<Bus> shared_this = shared_from_this();
+    for (RouteNode* node = start_; node != nullptr; node = node->next) {
+        node->stop->AddBus(shared_this);
+    }
+}
+
+void Bus::AppendStop(std::shared_ptr<Stop> stop) {
     RouteNode* new_node = new RouteNode(stop);
     if (size_ == 0) {
         start_ = new_node;
@@ -165,23 +205,42 @@ void Bus::AddStop(std::shared_ptr<Stop> stop) {
             new_node->prev = end_;
         }
         end_->next = new_node;
-        double geo_distance = ComputeDistance(last_stop_.lock()->GetCoordinates(), stop->GetCoordinates());
-        length_ += geo_distance; 
         full_length_ += catalogue_.GetDistance(last_stop_, stop);
         if (IsLine()) {
-            length_ += geo_distance;
             full_length_ += catalogue_.GetDistance(stop, last_stop_);
         }
         end_ = new_node;
     }
     last_stop_ = stop;
-    std::shared_ptr<Bus> shared_this = shared_from_this();
-    stop->AddBus(std::shared_ptr<Bus>(shared_this));
     ++size_;
 }
 
-double Bus::GetCurvature() {
-    return static_cast<double>(full_length_/length_); 
+void Bus::ComputeGeoLength() {
+    std::vector<Geo::Coordinates> points;
+    std::vector<Geo::LatitudeTrig> trig;
+    points.reserve(size_);
+    trig.reserve(size_);
+    for (const RouteNode* node = start_; node != nullptr; node = node->next) {
+        points.push_back(node->stop->GetCoordinates());
+        trig.push_back(node->stop->GetLatitudeTrig());
+    }
+    /* Порядок сложения прежний: для линейного маршрута каждый отрезок учитывается дважды подряд */
+    double length = 0;
+    for (double geo_distance : Geo::ComputeConsecutiveDistances(points, trig)) {
+        length += geo_distance;
+        if (type_ == RouteType::Line) {
+            length += geo_distance;
+        }
+    }
+    geo_length_ = length;
+}
+
+double Bus::GetGeoLength() const {
+    return geo_length_;
+}
+
+double Bus::GetCurvature() const {
+    return static_cast<double>(full_length_/geo_length_); 
 }
 
 std::size_t Bus::GetRouteSize() const {
@@ -196,8 +255,14 @@ bool Bus::IsEmpty() const {
     return size_ == 0; 
 }
 
-std::size_t Bus::GetUniqueStopsSize() {
-    return unique_stops_.size();
+std::size_t Bus::GetUniqueStopsSize() const {
+    std::vector<const Stop*> stops;
+    stops.reserve(size_);
+    for (const RouteNode* node = start_; node != nullptr; node = node->next) {
+        stops.push_back(node->stop.get());
+    }
+    std::sort(stops.begin(), stops.end());
+    return std::unique(stops.begin(), stops.end()) - stops.begin();
 };
 
 inline std::size_t Transport::BusHasher::operator()(const std::weak_ptr<Bus>& bus) const {
@@ -240,15 +305,15 @@ void Catalogue::AddBus(std::shared_ptr<Bus> bus) {
 }
  
 const std::shared_ptr<Stop> Catalogue::GetStop(std::string_view stop_name) const {
-    if (stops_dictionary_.count(stop_name)) {
-        return stops_dictionary_.at(stop_name);
+    if (auto it = stops_dictionary_.find(stop_name); it != stops_dictionary_.end()) {
+        return it->second;
     }
     return nullptr;
 }
  
 const std::shared_ptr<Bus> Catalogue::GetBus(std::string_view bus_name) const {
-    if (buses_dictionary_.count(bus_name)) {
-        return buses_dictionary_.at(bus_name);
+    if (auto it = buses_dictionary_.find(bus_name); it != buses_dictionary_.end()) {
+        return it->second;
     }
     return nullptr;
 }
@@ -262,8 +327,10 @@ const StopsDictionary& Catalogue::GetAllStops() const {
 }
 
 void Catalogue::SetDistance(std::string_view stop_a_name, std::string_view stop_b_name, std::size_t distance) {
-    std::shared_ptr<Stop> stop_a = GetStop(stop_a_name);
-    std::shared_ptr<Stop> stop_b = GetStop(stop_b_name);
+    SetDistance(GetStop(stop_a_name), GetStop(stop_b_name), distance);
+}
+
+void Catalogue::SetDistance(const std::shared_ptr<Stop>& stop_a, const std::shared_ptr<Stop>& stop_b, std::size_t distance) {
     stop_a->AddAdjacent(stop_b->GetName(), distance);
     stop_b->AddAdjacent(stop_a->GetName(), distance);
     SetDistance(std::weak_ptr(stop_a), std::weak_ptr(stop_b), distance);
@@ -281,12 +348,12 @@ std::size_t Catalogue::GetDistance(std::string_view stop_a_name, std::string_vie
 
 std::size_t Catalogue::GetDistance(const std::weak_ptr<Stop> a, const std::weak_ptr<Stop> b) const {
     RoadMapSegment segment{a, b};
-    if (segments_.count(segment)) {
-        return segments_.at(segment);
+    if (auto it = segments_.find(segment); it != segments_.end()) {
+        return it->second;
     }
     RoadMapSegment segment_reverse{b, a};
-    if (segments_.count(segment_reverse)) {
-        return segments_.at(segment_reverse);
+    if (auto it = segments_.find(segment_reverse); it != segments_.end()) {
+        return it->second;
     }
     // Расстояние до самой себя по-умолчанию
     return 0;
@@ -295,4 +362,51 @@ const Transport::SegmentsMap& Catalogue::GetSegmentsMap() const {
     return segments_; 
 }
 
+std::shared_ptr<const CatalogueSnapshot> Catalogue::Finalize(const SnapshotOptions& options) {
+    if (routes_released_) {
+        throw std::logic_error("Catalogue routes are released, snapshot can't be rebuilt"s);
+    }
+    snapshot_ = std::make_shared<const CatalogueSnapshot>(*this, options);
+    /* Сжатый снимок — единственная копия маршрутов: списки автобусов больше не нужны */
+    if (options.compact_routes) {
+        for (const std::shared_ptr<Bus>& bus : buses_) {
+            bus->ReleaseRoute();
+        }
+        routes_released_ = true;
+    }
+    return snapshot_;
+}
+
+memory::Usage Catalogue::GetMemoryUsage() const {
+    memory::Usage usage{ "catalogue", sizeof(Catalogue), {} };
+
+    std::size_t stops_bytes = 0;
+    for (const std::shared_ptr<Stop>& stop : stops_) {
+        stops_bytes += stop->GetMemoryUsage();
+    }
+    std::size_t buses_bytes = 0;
+    for (const std::shared_ptr<Bus>& bus : buses_) {
+        buses_bytes += bus->GetMemoryUsage();
+    }
+    usage.AddPart("stops", memory::GetHeapBytes(stops_) + stops_bytes);
+    usage.AddPart("buses", memory::GetHeapBytes(buses_) + buses_bytes);
+    usage.AddPart(
+        memory::Usage{ "dictionaries", 0, {} }
+            .AddPart("stops", memory::GetHeapBytes(stops_dictionary_))
+            .AddPart("buses", memory::GetHeapBytes(buses_dictionary_))
+    );
+    usage.AddPart("segments", memory::GetHeapBytes(segments_));
+    if (snapshot_) {
+        usage.AddPart(snapshot_->GetMemoryUsage());
+    }
+    return usage;
+}
+
+std::shared_ptr<const CatalogueSnapshot> Catalogue::GetSnapshot() const {
+    if (!snapshot_) {
+        throw std::logic_error("Catalogue is not finalized"s);
+    }
+    return snapshot_;
+}
+
 } // end Transport
\ No newline at end of file
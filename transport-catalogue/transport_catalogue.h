@@ -14,6 +14,7 @@
  
 #include "domain.h"
 #include "geo.h"
+#include "memory_usage.h"
 
 namespace Transport {
 
@@ -23,6 +24,7 @@ class Bus;
 class Stop;
 class RoadMapSegment;
 class Catalogue;
+class CatalogueSnapshot;
 
 struct RoadMapSegment {
     std::weak_ptr<Stop> a;
@@ -55,11 +57,15 @@ using StopsBuses = std::unordered_set<std::weak_ptr<Bus>, BusHasher, BusEqual>;
 class Stop : public std::enable_shared_from_this<Stop> {
 
 public:
-    explicit Stop(std::string name, Geo::Coordinates coordinates) : name_(name), coordinates_(coordinates) {}
+    explicit Stop(std::string name, Geo::Coordinates coordinates) : 
+        name_(name), 
+        coordinates_(coordinates),
+        latitude_trig_(Geo::ComputeLatitudeTrig(coordinates)) {}
 
     const std::string& GetName() const;
 
     const Geo::Coordinates& GetCoordinates() const;
+    const Geo::LatitudeTrig& GetLatitudeTrig() const;
 
     bool operator==(const Stop* other) const;
     bool operator!=(const Stop* other) const;
@@ -76,9 +82,12 @@ public:
 
     const std::set<std::string_view>& GetBusNames() const;
 
+    std::size_t GetMemoryUsage() const;
+
 private:
     std::string name_;
     Geo::Coordinates coordinates_;
+    Geo::LatitudeTrig latitude_trig_;
     StopsBuses unique_buses_;
     std::unordered_map<std::string_view, std::size_t> distance_to_adjacent_stops_;
     std::set<std::string_view> sorted_bus_names_;
@@ -196,14 +205,27 @@ public:
 
     void AddStop(std::shared_ptr<Stop> stop);
 
-    double GetCurvature();
+    /**
+     * Добавляет остановку в маршрут, не регистрируя автобус на самой остановке.
+     * Не меняет общих данных, поэтому маршруты разных автобусов можно строить параллельно.
+    */
+    void AppendStop(std::shared_ptr<Stop> stop);
+
+    /* Регистрирует автобус на всех остановках маршрута, добавленных через AppendStop */
+    void RegisterOnStops();
+
+    /**
+     * Считает географическую длину одним пакетным вызовом по всему маршруту и запоминает её.
+     * Вызывается после добавления всех остановок, на этапе построения маршрутов.
+    */
+    void ComputeGeoLength();
+    double GetGeoLength() const;
+    double GetCurvature() const;
 
     bool IsEmpty() const;
 
     std::size_t GetSize() const;
 
-    std::vector<std::weak_ptr<Stop>> GetUniqueStops();
-
     bool IsLine() {
         return type_ == RouteType::Line;
     }
@@ -212,16 +234,20 @@ public:
 
     std::size_t GetRouteLength() const ;
     std::size_t GetRouteSize() const;
-    std::size_t GetUniqueStopsSize();
+    /* Считается по маршруту при каждом вызове; снимок вызывает один раз и хранит результат */
+    std::size_t GetUniqueStopsSize() const;
     const std::string& GetName() const;
 
+    std::size_t GetMemoryUsage() const;
+
+    /**
+     * Освобождает список остановок маршрута. После вызова маршрут пуст,
+     * поэтому характеристики автобуса берутся только из снимка каталога.
+    */
+    void ReleaseRoute();
+
     ~Bus() {
-        RouteNode* current = begin();
-        while (current != nullptr) {
-            RouteNode* temp = current;
-            current = current->next;
-            delete temp;
-        }
+        ReleaseRoute();
     }
 
 private:
@@ -229,15 +255,20 @@ private:
     RouteType type_;
     RouteNode* current_;
     std::size_t size_ = 0;
-    double length_ = 0;
     double full_length_ = 0;
+    double geo_length_ = 0;
     RouteNode* start_ = nullptr;
     RouteNode* end_ = nullptr;
     std::weak_ptr<Stop> last_stop_;
-    std::unordered_set<std::weak_ptr<Stop>, StopHasher, StopEqual> unique_stops_;
     const Catalogue& catalogue_; 
 };
 
+/* Параметры построения снимка каталога */
+struct SnapshotOptions {
+    // Хранить последовательности остановок маршрутов сжатыми: разности идентификаторов в varint
+    bool compact_routes = false;
+};
+
 class Catalogue {
 public:
     explicit Catalogue() = default;
@@ -257,10 +288,22 @@ public:
     std::size_t GetDistance(std::string_view stop_a, std::string_view stop_b);
 
     void SetDistance(const std::weak_ptr<Stop> a, const std::weak_ptr<Stop> b, std::size_t distance);
+    void SetDistance(const std::shared_ptr<Stop>& a, const std::shared_ptr<Stop>& b, std::size_t distance);
     std::size_t GetDistance(const std::weak_ptr<Stop> a, const std::weak_ptr<Stop> b) const;
 
     const SegmentsMap& GetSegmentsMap() const;
 
+    /**
+     * Замораживает каталог: строит неизменяемый снимок для запросов.
+     * Повторный вызов перестраивает снимок по текущему состоянию.
+     * При compact_routes списки остановок автобусов после построения снимка
+     * освобождаются, и перестроить снимок уже нельзя.
+    */
+    std::shared_ptr<const CatalogueSnapshot> Finalize(const SnapshotOptions& options = {});
+    std::shared_ptr<const CatalogueSnapshot> GetSnapshot() const;
+
+    memory::Usage GetMemoryUsage() const;
+
     ~Catalogue() = default;
 
 private:
@@ -269,6 +312,8 @@ private:
     StopsDictionary stops_dictionary_;
     BusesDictionary buses_dictionary_;
     SegmentsMap segments_;
+    std::shared_ptr<const CatalogueSnapshot> snapshot_;
+    bool routes_released_ = false;
 };
 
 } // end Transport
\ No newline at end of file
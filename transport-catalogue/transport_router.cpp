@@ -2,98 +2,83 @@
 
 namespace Transport {
 
-const graph::DirectedWeightedGraph<double>& Router::BuildGraph(const Transport::Catalogue& catalogue) {
-
-    const std::map<std::string_view, std::shared_ptr<Transport::Stop>>& all_stops = catalogue.GetAllStops();
-    const std::map<std::string_view, std::shared_ptr<Transport::Bus>>& all_buses = catalogue.GetAllBuses();
-    graph::DirectedWeightedGraph<double> stops_graph(all_stops.size());
-    std::map<std::string, graph::VertexId> stop_ids;
-    std::map<graph::VertexId, std::string> id_stops;
-    graph::VertexId vertex_id = 0;
-
-    for (const auto& [stop_name, stop_info] : all_stops) {
-        stop_ids[stop_info->GetName()] = vertex_id;
-        id_stops[vertex_id] = stop_info->GetName();
-        ++vertex_id;
-    }
+const graph::DirectedWeightedGraph<double>& Router::BuildGraph(const Transport::CatalogueSnapshot& catalogue) {
 
-    stop_ids_ = std::move(stop_ids);
-    id_stops_ = std::move(id_stops);
-
-    for_each(
-        all_buses.begin(),
-        all_buses.end(),
-        [&stops_graph, this, &catalogue](const auto& item) {
-            const std::shared_ptr<Bus>& bus_ptr = item.second; // Указатель на Bus
-            auto firstRouteIt = bus_ptr->begin(); // Стартовая остановка маршрута
-            auto secondRouteIt = firstRouteIt->next;
-            size_t distance_between_stops = 1;
-            size_t start_window_length = 0;
-            size_t start_reverse_window_length = 0;
-            if (secondRouteIt) {
-                start_window_length += catalogue.GetDistance(firstRouteIt->stop, secondRouteIt->stop);
-                if (bus_ptr->IsLine()) {
-                    start_reverse_window_length += catalogue.GetDistance(secondRouteIt->stop, firstRouteIt->stop);
-                }
+    graph::DirectedWeightedGraph<double> stops_graph(catalogue.GetStopCount());
+
+    for (BusId bus_id = 0; bus_id < catalogue.GetBusCount(); ++bus_id) {
+        const CatalogueSnapshot::BusRecord& bus = catalogue.GetBus(bus_id);
+        const CatalogueSnapshot::StopIdRange route = catalogue.GetBusStops(bus_id);
+        const std::vector<StopId> stops(route.begin(), route.end());
+        const bool is_line = bus.type == RouteType::Line;
+        const size_t stops_count = stops.size();
+
+        size_t distance_between_stops = 1;
+        size_t start_window_length = 0;
+        size_t start_reverse_window_length = 0;
+        if (stops_count > 1) {
+            start_window_length += catalogue.GetDistance(stops[0], stops[1]);
+            if (is_line) {
+                start_reverse_window_length += catalogue.GetDistance(stops[1], stops[0]);
             }
-            while (secondRouteIt) {
-                /**
-                 * Формирование окна
-                 */
-                auto start_window_it = firstRouteIt;
-                auto end_window_it = secondRouteIt;
-                size_t window_length = start_window_length; 
-                size_t reverse_window_length = start_reverse_window_length; 
+        }
+        for (size_t second = 1; second < stops_count; ++second) {
+            /**
+             * Формирование окна
+             */
+            size_t start_window = 0;
+            size_t end_window = second;
+            size_t window_length = start_window_length; 
+            size_t reverse_window_length = start_reverse_window_length; 
 
+            /**
+             * Проход по остановкам, добавление рёбер графа.
+             */
+            while (end_window < stops_count) {
                 /**
-                 * Проход по остановкам, добавление рёбер графа.
+                 * Добавление рёбер
                  */
-                while (end_window_it) {
-                    /**
-                     * Добавление рёбер
-                     */
+                stops_graph.AddEdge({ 
+                    bus.name,
+                    distance_between_stops, 
+                    stops[start_window],
+                    stops[end_window],
+                    static_cast<double>(window_length) / (bus_velocity_ * (100.0 / 6.0)) + bus_wait_time_
+                });
+                if (is_line) {
                     stops_graph.AddEdge({ 
-                        bus_ptr->GetName(),
+                        bus.name,
                         distance_between_stops, 
-                        stop_ids_.at(start_window_it->stop->GetName()),
-                        stop_ids_.at(end_window_it->stop->GetName()),
-                        static_cast<double>(window_length) / (bus_velocity_ * (100.0 / 6.0)) + bus_wait_time_
+                        stops[end_window],
+                        stops[start_window],
+                        static_cast<double>(reverse_window_length) / (bus_velocity_ * (100.0 / 6.0)) + bus_wait_time_
                     });
-                    if (bus_ptr->IsLine()) {
-                        stops_graph.AddEdge({ 
-                            bus_ptr->GetName(),
-                            distance_between_stops, 
-                            stop_ids_.at(end_window_it->stop->GetName()),
-                            stop_ids_.at(start_window_it->stop->GetName()),
-                            static_cast<double>(reverse_window_length) / (bus_velocity_ * (100.0 / 6.0)) + bus_wait_time_
-                        });
-                    }
-                    /**
-                     * Сдвиг окна
-                     */
-                    if (end_window_it->next) {
-                        window_length += catalogue.GetDistance(end_window_it->stop, end_window_it->next->stop);
-                        window_length -= catalogue.GetDistance(start_window_it->stop, start_window_it->next->stop);
-                        if (bus_ptr->IsLine()) {
-                            reverse_window_length += catalogue.GetDistance(end_window_it->next->stop, end_window_it->stop);
-                            reverse_window_length -= catalogue.GetDistance(start_window_it->next->stop, start_window_it->stop);
-                        }
-                    }
-                    start_window_it = start_window_it->next;
-                    end_window_it = end_window_it->next;
                 }
-
                 /**
-                 * Увеличение окна
+                 * Сдвиг окна
                  */
-                ++distance_between_stops;
-                if (secondRouteIt->next) {
-                    start_window_length += catalogue.GetDistance(secondRouteIt->stop, secondRouteIt->next->stop);
-                    start_reverse_window_length += catalogue.GetDistance(secondRouteIt->next->stop, secondRouteIt->stop);
+                if (end_window + 1 < stops_count) {
+                    window_length += catalogue.GetDistance(stops[end_window], stops[end_window + 1]);
+                    window_length -= catalogue.GetDistance(stops[start_window], stops[start_window + 1]);
+                    if (is_line) {
+                        reverse_window_length += catalogue.GetDistance(stops[end_window + 1], stops[end_window]);
+                        reverse_window_length -= catalogue.GetDistance(stops[start_window + 1], stops[start_window]);
+                    }
                 }
-                secondRouteIt = secondRouteIt->next;
+                ++start_window;
+                ++end_window;
+            }
+
+            /**
+             * Увеличение окна
+             */
+            ++distance_between_stops;
+            if (second + 1 < stops_count) {
+                start_window_length += catalogue.GetDistance(stops[second], stops[second + 1]);
+                start_reverse_window_length += catalogue.GetDistance(stops[second + 1], stops[second]);
             }
-        });
+        }
+    }
     graph_ = std::move(stops_graph);
     router_ = std::make_unique<graph::Router<double>>(graph_);
 
@@ -101,7 +86,47 @@ const graph::DirectedWeightedGraph<double>& Router::BuildGraph(const Transport::
 }
 
 const std::optional<graph::Router<double>::RouteInfo> Router::FindRoute(const std::string_view stop_from, const std::string_view stop_to) const {
-    return router_->BuildRoute(stop_ids_.at(std::string(stop_from)), stop_ids_.at(std::string(stop_to)));
+    const std::optional<StopId> from = snapshot_->FindStop(stop_from);
+    const std::optional<StopId> to = snapshot_->FindStop(stop_to);
+    if (!from || !to) {
+        return std::nullopt;
+    }
+    return FindRoute(*from, *to);
+}
+
+const std::optional<graph::Router<double>::RouteInfo> Router::FindRoute(StopId from, StopId to) const {
+    return router_->BuildRoute(from, to);
+}
+
+const std::optional<graph::Router<double>::RouteInfo> Router::FindDirectRoute(const std::string_view stop_from, const std::string_view stop_to) const {
+    const std::optional<StopId> from = snapshot_->FindStop(stop_from);
+    const std::optional<StopId> to = snapshot_->FindStop(stop_to);
+    if (!from || !to) {
+        return std::nullopt;
+    }
+    return FindDirectRoute(*from, *to);
+}
+
+const std::optional<graph::Router<double>::RouteInfo> Router::FindDirectRoute(StopId from, StopId to) const {
+    if (from == to) {
+        return graph::Router<double>::RouteInfo{ 0.0, {} };
+    }
+    if (!snapshot_->HasDirectBus(from, to)) {
+        return std::nullopt;
+    }
+    // Общий автобус может идти только в обратную сторону, поэтому ребро ещё нужно найти
+    std::optional<graph::Router<double>::RouteInfo> route;
+    for (const graph::EdgeId edge_id : graph_.GetIncidentEdges(from)) {
+        const graph::Edge<double>& edge = graph_.GetEdge(edge_id);
+        if (edge.to == to && (!route || edge.weight < route->weight)) {
+            route = graph::Router<double>::RouteInfo{ edge.weight, { edge_id } };
+        }
+    }
+    return route;
+}
+
+std::optional<double> Router::GetTravelTime(StopId from, StopId to) const {
+    return router_->GetRouteWeight(from, to);
 }
 
 const graph::DirectedWeightedGraph<double>& Router::GetGraph() const {
@@ -116,8 +141,7 @@ Router& Router::operator=(Router&& other) noexcept {
         bus_wait_time_ = other.bus_wait_time_;
         bus_velocity_ = other.bus_velocity_;
         graph_ = std::move(other.graph_);
-        stop_ids_ = std::move(other.stop_ids_);
-        id_stops_ = std::move(other.id_stops_);
+        snapshot_ = std::move(other.snapshot_);
         router_ = std::move(other.router_);
     }
     return *this;
@@ -136,7 +160,7 @@ const std::pair<std::vector<domain::PassengerAction>, double> Router::GetRoute(g
                         .Key("time")
                         .Value(bus_wait_time_)
                         .Key("stop_name")
-                        .Value(id_stops_.at(edge.from))
+                        .Value(snapshot_->GetStop(static_cast<StopId>(edge.from)).name)
                         .Key("type")
                         .Value("Wait")
                     .EndDict()
@@ -164,4 +188,15 @@ const std::pair<std::vector<domain::PassengerAction>, double> Router::GetRoute(g
     return { items, total_time };
 }
 
+memory::Usage Router::GetMemoryUsage() const {
+    std::size_t edge_names_bytes = 0;
+    for (graph::EdgeId edge_id = 0; edge_id < graph_.GetEdgeCount(); ++edge_id) {
+        edge_names_bytes += memory::GetHeapBytes(graph_.GetEdge(edge_id).name);
+    }
+    return memory::Usage{ "router", sizeof(Router), {} }
+        .AddPart("graph_edges", graph_.GetEdgesMemoryUsage() + edge_names_bytes)
+        .AddPart("incidence_lists", graph_.GetIncidenceMemoryUsage())
+        .AddPart("route_table", router_ ? sizeof(graph::Router<double>) + router_->GetMemoryUsage() : 0);
+}
+
 } // end Transport
\ No newline at end of file
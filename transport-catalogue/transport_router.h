@@ -2,6 +2,7 @@
 #include "chrono"
 #include <memory>
 
+#include "catalogue_snapshot.h"
 #include "router.h"
 #include "transport_catalogue.h"
 
@@ -12,14 +13,30 @@ class RouterCreator;
 class Router {
     friend RouterCreator;
 public:
-    const graph::DirectedWeightedGraph<double>& BuildGraph(const Transport::Catalogue& catalogue);
+    const graph::DirectedWeightedGraph<double>& BuildGraph(const Transport::CatalogueSnapshot& catalogue);
+    /**
+     * Лучший маршрут с пересадками. Кратчайшие пути между всеми парами остановок
+     * считаются при построении маршрутизатора, запрос только читает таблицу,
+     * поэтому проверка общего автобуса по битовым множествам здесь ничего не отсекает.
+    */
     const std::optional<graph::Router<double>::RouteInfo> FindRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+    /**
+     * Лучший маршрут без пересадок: одно ребро графа от from до to.
+     * Остановки без общего автобуса отсекаются по битовым множествам снимка без обхода рёбер.
+    */
+    const std::optional<graph::Router<double>::RouteInfo> FindDirectRoute(const std::string_view stop_from, const std::string_view stop_to) const;
+    /* То же для остановок, уже найденных в снимке маршрутизатора */
+    const std::optional<graph::Router<double>::RouteInfo> FindRoute(StopId from, StopId to) const;
+    const std::optional<graph::Router<double>::RouteInfo> FindDirectRoute(StopId from, StopId to) const;
     const graph::DirectedWeightedGraph<double>& GetGraph() const;
-
-    Router(const domain::RouterSettings& settings, const Transport::Catalogue& catalogue) {
-        bus_wait_time_ = settings.GetBusWaitTime();
-        bus_velocity_ = settings.GetBusVelocity();
-        BuildGraph(catalogue);
+    /* Время кратчайшего маршрута между остановками снимка или nullopt, если маршрута нет */
+    std::optional<double> GetTravelTime(StopId from, StopId to) const;
+
+    Router(const RouterSettings& settings, const Transport::Catalogue& catalogue) {
+        bus_wait_time_ = settings.bus_wait_time;
+        bus_velocity_ = settings.bus_velocity;
+        snapshot_ = catalogue.GetSnapshot();
+        BuildGraph(*snapshot_);
     }
 
     Router(const Router&) = delete;
@@ -29,8 +46,7 @@ public:
         : bus_wait_time_(other.bus_wait_time_),
         bus_velocity_(other.bus_velocity_),
         graph_(std::move(other.graph_)),
-        stop_ids_(std::move(other.stop_ids_)),
-        id_stops_(std::move(other.id_stops_)),
+        snapshot_(std::move(other.snapshot_)),
         router_(std::move(other.router_)) 
     {}
 
@@ -39,12 +55,15 @@ public:
 
     const std::pair<std::vector<domain::PassengerAction>, double> GetRoute(graph::Router<double>::RouteInfo& routing) const;
 
+    /* Снимок каталога общий с каталогом и в отчёт маршрутизатора не входит */
+    memory::Usage GetMemoryUsage() const;
+
 private:
     int bus_wait_time_ = 0;
     double bus_velocity_ = 0.0;
     graph::DirectedWeightedGraph<double> graph_;
-    std::map<std::string, graph::VertexId> stop_ids_;
-    std::map<graph::VertexId, std::string> id_stops_;
+    // Вершина графа совпадает с идентификатором остановки в снимке
+    std::shared_ptr<const CatalogueSnapshot> snapshot_;
     std::unique_ptr<graph::Router<double>> router_;
 };
 
@@ -52,7 +71,7 @@ class RouterCreator {
 public:
     RouterCreator() = default;
 
-    RouterCreator& SetSettings(domain::RouterSettings& settings) {
+    RouterCreator& SetSettings(RouterSettings& settings) {
         settings_ = &settings;
         return *this;
     }
@@ -71,7 +90,7 @@ public:
 
 private: 
     Catalogue* catalogue_ = nullptr;
-    domain::RouterSettings* settings_ = nullptr;
+    RouterSettings* settings_ = nullptr;
 };
 
 }
\ No newline at end of file